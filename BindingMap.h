@@ -12,9 +12,13 @@
 #ifndef _BINDING_MAP_H
 #define _BINDING_MAP_H
 
+#include <algorithm>
+#include <deque>
 #include <memory>
 #include "Common.h"
 #include "ForgeUtility.h"
+#include "Hooks.h"
+#include "Opcodes.h"
 #include <type_traits>
 
 extern "C"
@@ -23,58 +27,588 @@ extern "C"
 #include "lauxlib.h"
 };
 
+template<typename K> struct BindingKeyTraits;
 
 /*
- * A set of bindings from keys of type `K` to Lua references.
+ * Tracks, for every `Hooks::RegisterTypes`, which event IDs have at least one
+ *   binding in any of the state's `BindingMap`s.
+ *
+ * Hooks test this before building a key, so events that nothing is bound to
+ *   cost a single bit test instead of a lookup.
  */
-template<typename K>
-class BindingMap
+class BindingMask
 {
+public:
+    // Every hook event enum must fit in one 64-bit row (see `EventIdBound`).
+    static constexpr std::size_t MAX_EVENTS = 64;
+
+    BindingMask() :
+        bits(),
+        counts()
+#if defined FORGE_DEBUG
+        , fastPathHits(0),
+        hookCalls(0)
+#endif
+    { }
+
+    /*
+     * Check whether anything is bound to `event_id` of `regtype`.
+     */
+    bool IsBound(Hooks::RegisterTypes regtype, uint32 event_id)
+    {
+        bool bound = (bits[regtype] >> event_id) & 1;
+#if defined FORGE_DEBUG
+        ++hookCalls;
+        if (!bound)
+            ++fastPathHits;
+#endif
+        return bound;
+    }
+
+    /*
+     * Check whether anything is bound to `event_id` of either register type,
+     *   counted as a single hook call.
+     */
+    bool IsBoundAny(Hooks::RegisterTypes first, Hooks::RegisterTypes second, uint32 event_id)
+    {
+        bool bound = ((bits[first] | bits[second]) >> event_id) & 1;
+#if defined FORGE_DEBUG
+        ++hookCalls;
+        if (!bound)
+            ++fastPathHits;
+#endif
+        return bound;
+    }
+
+    void Add(Hooks::RegisterTypes regtype, uint32 event_id, uint32 count = 1)
+    {
+        if (!count)
+            return;
+
+        counts[regtype][event_id] += count;
+        bits[regtype] |= uint64(1) << event_id;
+    }
+
+    void Remove(Hooks::RegisterTypes regtype, uint32 event_id, uint32 count = 1)
+    {
+        ASSERT(counts[regtype][event_id] >= count);
+
+        counts[regtype][event_id] -= count;
+        if (!counts[regtype][event_id])
+            bits[regtype] &= ~(uint64(1) << event_id);
+    }
+
+#if defined FORGE_DEBUG
+    uint64 GetFastPathHits() const { return fastPathHits; }
+    uint64 GetHookCalls() const { return hookCalls; }
+#endif
+
 private:
-    lua_State* L;
-    uint64 maxBindingID;
+    uint64 bits[Hooks::REGTYPE_COUNT];
+    uint32 counts[Hooks::REGTYPE_COUNT][MAX_EVENTS];
+#if defined FORGE_DEBUG
+    uint64 fastPathHits;
+    uint64 hookCalls;
+#endif
+};
+
+/*
+ * The bindings of a single key, stored as parallel arrays of IDs,
+ *   Lua references and remaining shots.
+ *
+ * Up to `INLINE_CAPACITY` bindings live inside the list itself, which keeps
+ *   the common case of a few handlers per key to one cache line. Larger lists
+ *   spill into a single heap block holding all three arrays.
+ *
+ * Removed and expired bindings leave a tombstone (a `LUA_NOREF` reference) in
+ *   their slot, so they can be dropped in O(1) without shifting the others.
+ *   The owner calls `Compact` to squeeze them out, keeping the order of the
+ *   remaining bindings.
+ */
+class BindingList
+{
+public:
+    static constexpr uint32 INLINE_CAPACITY = 3;
 
-    struct Binding
+    BindingList() :
+        count(0),
+        live(0),
+        capacity(INLINE_CAPACITY)
+    { }
+
+    BindingList(BindingList&& other) noexcept :
+        count(other.count),
+        live(other.live),
+        capacity(other.capacity),
+        storage(other.storage)
+    {
+        other.count = 0;
+        other.live = 0;
+        other.capacity = INLINE_CAPACITY;
+    }
+
+    BindingList(const BindingList&) = delete;
+    BindingList& operator=(const BindingList&) = delete;
+    BindingList& operator=(BindingList&&) = delete;
+
+    ~BindingList()
+    {
+        if (IsOnHeap())
+            delete[] reinterpret_cast<char*>(storage.heap.ids);
+    }
+
+    // Number of slots in use, including tombstones.
+    uint32 Size() const { return count; }
+    // Number of bindings that are not tombstones.
+    uint32 Live() const { return live; }
+
+    uint64 Id(uint32 slot) const { return Ids()[slot]; }
+    int Ref(uint32 slot) const { return Refs()[slot]; }
+    uint32& Shots(uint32 slot) { return ShotsArray()[slot]; }
+    bool IsTombstone(uint32 slot) const { return Refs()[slot] == LUA_NOREF; }
+
+    /*
+     * Append a binding and return its slot.
+     */
+    uint32 Add(uint64 id, int ref, uint32 shots)
+    {
+        if (count == capacity)
+            Grow();
+
+        uint32 slot = count++;
+        Ids()[slot] = id;
+        Refs()[slot] = ref;
+        ShotsArray()[slot] = shots;
+        ++live;
+        return slot;
+    }
+
+    /*
+     * Turn the binding in `slot` into a tombstone and return its reference.
+     */
+    int Kill(uint32 slot)
     {
-        uint64 id;
-        lua_State* L;
-        uint32 remainingShots;
-        int functionReference;
+        ASSERT(!IsTombstone(slot));
+
+        int ref = Refs()[slot];
+        Refs()[slot] = LUA_NOREF;
+        --live;
+        return ref;
+    }
 
-        Binding(lua_State* L, uint64 id, int functionReference, uint32 remainingShots) :
-            id(id),
-            L(L),
-            remainingShots(remainingShots),
-            functionReference(functionReference)
-        { }
+    /*
+     * Remove every tombstone, calling `moved(id, slot)` for each binding
+     *   that ends up in a different slot.
+     */
+    template<typename F>
+    void Compact(F moved)
+    {
+        uint64* ids = Ids();
+        int* refs = Refs();
+        uint32* shots = ShotsArray();
 
-        ~Binding()
+        uint32 out = 0;
+        for (uint32 in = 0; in < count; ++in)
         {
-            luaL_unref(L, LUA_REGISTRYINDEX, functionReference);
+            if (refs[in] == LUA_NOREF)
+                continue;
+
+            if (in != out)
+            {
+                ids[out] = ids[in];
+                refs[out] = refs[in];
+                shots[out] = shots[in];
+                moved(ids[out], out);
+            }
+            ++out;
         }
+
+        count = out;
+        ASSERT(count == live);
+    }
+
+    /*
+     * Drop every slot. The caller is responsible for the references.
+     */
+    void Clear()
+    {
+        count = 0;
+        live = 0;
+    }
+
+private:
+    uint32 count;
+    uint32 live;
+    uint32 capacity;
+
+    union Storage
+    {
+        struct
+        {
+            uint64 ids[INLINE_CAPACITY];
+            int refs[INLINE_CAPACITY];
+            uint32 shots[INLINE_CAPACITY];
+        } local;
+
+        struct
+        {
+            uint64* ids;
+            int* refs;
+            uint32* shots;
+        } heap;
+    } storage;
+
+    bool IsOnHeap() const { return capacity > INLINE_CAPACITY; }
+
+    uint64* Ids() { return IsOnHeap() ? storage.heap.ids : storage.local.ids; }
+    const uint64* Ids() const { return IsOnHeap() ? storage.heap.ids : storage.local.ids; }
+    int* Refs() { return IsOnHeap() ? storage.heap.refs : storage.local.refs; }
+    const int* Refs() const { return IsOnHeap() ? storage.heap.refs : storage.local.refs; }
+    uint32* ShotsArray() { return IsOnHeap() ? storage.heap.shots : storage.local.shots; }
+
+    void Grow()
+    {
+        uint32 newCapacity = capacity * 2;
+
+        // One block for all three arrays, widest type first to keep them aligned.
+        char* block = new char[newCapacity * (sizeof(uint64) + sizeof(int) + sizeof(uint32))];
+        uint64* ids = reinterpret_cast<uint64*>(block);
+        int* refs = reinterpret_cast<int*>(ids + newCapacity);
+        uint32* shots = reinterpret_cast<uint32*>(refs + newCapacity);
+
+        std::copy(Ids(), Ids() + count, ids);
+        std::copy(Refs(), Refs() + count, refs);
+        std::copy(ShotsArray(), ShotsArray() + count, shots);
+
+        if (IsOnHeap())
+            delete[] reinterpret_cast<char*>(storage.heap.ids);
+
+        storage.heap.ids = ids;
+        storage.heap.refs = refs;
+        storage.heap.shots = shots;
+        capacity = newCapacity;
+    }
+};
+
+/*
+ * An open-addressing hash map from 32-bit entry IDs (creature entries,
+ *   map IDs, etc.) to small values, using linear probing.
+ *
+ * Entries are never erased; owners reset the value instead. That keeps
+ *   probing free of tombstones, and the number of entries is bounded by
+ *   the distinct IDs a state ever binds to.
+ */
+template<typename V>
+class EntryIndex
+{
+public:
+    EntryIndex() :
+        used(0),
+        shift(32)
+    { }
+
+    /*
+     * Returns the value stored for `entry`, or NULL if there is none.
+     */
+    V* Find(uint32 entry)
+    {
+        if (slots.empty())
+            return NULL;
+
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t i = Hash(entry); ; i = (i + 1) & mask)
+        {
+            Slot& slot = slots[i];
+            if (!slot.used)
+                return NULL;
+            if (slot.entry == entry)
+                return &slot.value;
+        }
+    }
+
+    /*
+     * Returns the value stored for `entry`, inserting a value-initialized one if needed.
+     */
+    V& FindOrInsert(uint32 entry)
+    {
+        // Keep the load factor at or below 1/2 so probe sequences stay short.
+        if ((used + 1) * 2 > slots.size())
+            Grow();
+
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t i = Hash(entry); ; i = (i + 1) & mask)
+        {
+            Slot& slot = slots[i];
+            if (!slot.used)
+            {
+                slot.used = true;
+                slot.entry = entry;
+                slot.value = V();
+                ++used;
+                return slot.value;
+            }
+            if (slot.entry == entry)
+                return slot.value;
+        }
+    }
+
+    void Clear()
+    {
+        slots.clear();
+        used = 0;
+        shift = 32;
+    }
+
+private:
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+    struct Slot
+    {
+        uint32 entry;
+        bool used;
+        V value;
     };
 
-    typedef std::vector< std::unique_ptr<Binding> > BindingList;
+    std::vector<Slot> slots;
+    std::size_t used;
+    uint32 shift;
+
+    // Fibonacci hashing: the top bits of the product are well mixed even for sequential entries.
+    std::size_t Hash(uint32 entry) const { return std::size_t(uint32(entry * 2654435769u) >> shift); }
+
+    void Grow()
+    {
+        std::vector<Slot> old;
+        old.swap(slots);
+
+        std::size_t capacity = old.empty() ? MIN_CAPACITY : old.size() * 2;
+        slots.resize(capacity, Slot());
+        used = 0;
+        shift = 32;
+        for (std::size_t c = capacity; c > 1; c >>= 1)
+            --shift;
+
+        for (Slot& slot : old)
+            if (slot.used)
+                FindOrInsert(slot.entry) = slot.value;
+    }
+};
+
+/*
+ * A set of bindings from keys of type `K` to Lua references.
+ *
+ * Keys with a compile-time bound (see `BindingKeyTraits`) are stored in a flat
+ *   table indexed by the key, so checking for bindings is a single indexed load.
+ *   Event/entry keys are indexed by event ID first and then by entry in an
+ *   `EntryIndex`, which also keeps a per-entry count of bindings for all events.
+ *   All other keys are stored in a hash map.
+ */
+template<typename K>
+class BindingMap
+{
+private:
+    // Refers to `Forge::L`, so handlers are pushed onto the stack of the running coroutine
+    lua_State*& L;
+    uint64 maxBindingID;
+    BindingMask* mask;
+    Hooks::RegisterTypes regtype;
+    // Number of bindings per event ID held by this map, so `Clear()` can update `mask`.
+    uint32 eventCounts[BindingMask::MAX_EVENTS];
+    uint32 liveBindings;
+
+    typedef BindingKeyTraits<K> KeyTraits;
+
+    /*
+     * Where a binding is stored, so it can be removed by ID in O(1).
+     */
+    struct BindingLocation
+    {
+        BindingList* list;
+        uint32 slot;
+        uint32 event_id;
+        uint32 entry;
+    };
 
     std::unordered_map<K, BindingList> bindings;
+    /*
+     * Flat table used instead of `bindings` when `K` is a dense key.
+     *
+     * It is only allocated on the first `Insert`, so states that never bind
+     *   anything for this key type don't pay for the table. Once allocated it
+     *   is never resized, which keeps the pointers in `id_lookup_table` valid.
+     */
+    std::vector<BindingList> dense_bindings;
+    /*
+     * Two-level index used instead of `bindings` when `K` is keyed by entry:
+     *   one `EntryIndex` per event ID, pointing into `entry_lists`.
+     *
+     * `entry_lists` is a deque so the lists never move, which keeps the
+     *   pointers in `id_lookup_table` valid. Cleared lists are kept around
+     *   for reuse instead of being erased.
+     */
+    std::vector< EntryIndex<BindingList*> > entry_bindings;
+    std::deque<BindingList> entry_lists;
+    // Number of bindings for each entry, summed over all events.
+    EntryIndex<uint32> entry_summary;
     /*
      * This table is for fast removal of bindings by ID.
      *
      * Instead of having to look through (potentially) every BindingList to find
      *   the Binding with the right ID, this allows you to go directly to the
-     *   BindingList that might have the Binding with that ID.
+     *   slot of the binding with that ID.
      *
      * However, you must be careful not to store pointers to BindingLists
-     *   that no longer exist (see `void Clear(const K& key)` implementation).
+     *   that no longer exist (see `void Clear(const K& key)` implementation),
+     *   and to update the slots of bindings moved by `BindingList::Compact`.
      */
-    std::unordered_map<uint64, BindingList*> id_lookup_table;
+    std::unordered_map<uint64, BindingLocation> id_lookup_table;
 
 public:
-    BindingMap(lua_State* L) :
+    BindingMap(lua_State*& L, BindingMask* mask, Hooks::RegisterTypes regtype) :
         L(L),
-        maxBindingID(0)
+        maxBindingID(0),
+        mask(mask),
+        regtype(regtype),
+        eventCounts(),
+        liveBindings(0)
     { }
 
+    ~BindingMap()
+    {
+        Clear();
+    }
+
+    Hooks::RegisterTypes GetRegisterType() const { return regtype; }
+
+private:
+    void AddToMask(uint32 event_id, uint32 entry, uint32 count = 1)
+    {
+        eventCounts[event_id] += count;
+        liveBindings += count;
+        mask->Add(regtype, event_id, count);
+
+        if constexpr (KeyTraits::by_entry)
+            entry_summary.FindOrInsert(entry) += count;
+    }
+
+    void RemoveFromMask(uint32 event_id, uint32 entry, uint32 count = 1)
+    {
+        eventCounts[event_id] -= count;
+        liveBindings -= count;
+        mask->Remove(regtype, event_id, count);
+
+        if constexpr (KeyTraits::by_entry)
+        {
+            uint32* summary = entry_summary.Find(entry);
+            ASSERT(summary && *summary >= count);
+            *summary -= count;
+        }
+    }
+
+    /*
+     * Returns the list of bindings for `key`, or NULL if there is none.
+     */
+    BindingList* Find(const K& key)
+    {
+        if constexpr (KeyTraits::dense)
+        {
+            if (dense_bindings.empty() || !KeyTraits::InRange(key))
+                return NULL;
+
+            return &dense_bindings[KeyTraits::Index(key)];
+        }
+        else if constexpr (KeyTraits::by_entry)
+        {
+            if (entry_bindings.empty() || !KeyTraits::InRange(key))
+                return NULL;
+
+            BindingList** list = entry_bindings[key.event_id].Find(key.entry);
+            return list ? *list : NULL;
+        }
+        else
+        {
+            if (bindings.empty())
+                return NULL;
+
+            auto result = bindings.find(key);
+            if (result == bindings.end())
+                return NULL;
+
+            return &result->second;
+        }
+    }
+
+    /*
+     * Returns the list of bindings for `key`, creating it if needed.
+     */
+    BindingList& FindOrCreate(const K& key)
+    {
+        if constexpr (KeyTraits::dense)
+        {
+            ASSERT(KeyTraits::InRange(key));
+
+            if (dense_bindings.empty())
+                dense_bindings.resize(KeyTraits::size);
+
+            return dense_bindings[KeyTraits::Index(key)];
+        }
+        else if constexpr (KeyTraits::by_entry)
+        {
+            ASSERT(KeyTraits::InRange(key));
+
+            if (entry_bindings.empty())
+                entry_bindings.resize(KeyTraits::size);
+
+            BindingList*& list = entry_bindings[key.event_id].FindOrInsert(key.entry);
+            if (!list)
+            {
+                entry_lists.emplace_back();
+                list = &entry_lists.back();
+            }
+            return *list;
+        }
+        else
+            return bindings[key];
+    }
+
+    static uint32 EntryOf(const K& key)
+    {
+        if constexpr (KeyTraits::by_entry)
+            return key.entry;
+        else
+            return 0;
+    }
+
+    /*
+     * Release the references of all live bindings in `list` and forget their IDs.
+     */
+    void ReleaseAll(BindingList& list)
+    {
+        for (uint32 slot = 0; slot < list.Size(); ++slot)
+        {
+            if (list.IsTombstone(slot))
+                continue;
+
+            id_lookup_table.erase(list.Id(slot));
+            luaL_unref(L, LUA_REGISTRYINDEX, list.Kill(slot));
+        }
+    }
+
+    /*
+     * Squeeze the tombstones out of `list` once they outnumber the live bindings.
+     *
+     * Each compaction is paid for by at least as many removals, so removal
+     *   stays O(1) amortized.
+     */
+    void CompactIfNeeded(BindingList& list)
+    {
+        if (list.Size() - list.Live() <= list.Live())
+            return;
+
+        list.Compact([this](uint64 id, uint32 slot) { id_lookup_table[id].slot = slot; });
+    }
+
+public:
     /*
      * Insert a new binding from `key` to `ref`, which lasts for `shots`-many pushes.
      *
@@ -84,9 +618,10 @@ public:
     uint64 Insert(const K& key, int ref, uint32 shots)
     {
         uint64 id = (++maxBindingID);
-        BindingList& list = bindings[key];
-        list.push_back(std::unique_ptr<Binding>(new Binding(L, id, ref, shots)));
-        id_lookup_table[id] = &list;
+        BindingList& list = FindOrCreate(key);
+        uint32 slot = list.Add(id, ref, shots);
+        id_lookup_table[id] = { &list, slot, uint32(key.event_id), EntryOf(key) };
+        AddToMask(key.event_id, EntryOf(key));
         return id;
     }
 
@@ -95,23 +630,17 @@ public:
      */
     void Clear(const K& key)
     {
-        if (bindings.empty())
-            return;
-
-        auto iter = bindings.find(key);
-        if (iter == bindings.end())
+        BindingList* list = Find(key);
+        if (!list)
             return;
 
-        BindingList& list = iter->second;
-
-        // Remove all pointers to `list` from `id_lookup_table`.
-        for (auto i = list.begin(); i != list.end(); ++i)
-        {
-            std::unique_ptr<Binding>& binding = *i;
-            id_lookup_table.erase(binding->id);
-        }
+        RemoveFromMask(key.event_id, EntryOf(key), list->Live());
+        ReleaseAll(*list);
 
-        bindings.erase(key);
+        if constexpr (KeyTraits::dense || KeyTraits::by_entry)
+            list->Clear();
+        else
+            bindings.erase(key);
     }
 
     /*
@@ -119,11 +648,30 @@ public:
      */
     void Clear()
     {
-        if (bindings.empty())
+        if (bindings.empty() && dense_bindings.empty() && entry_lists.empty())
             return;
 
+        for (uint32 event_id = 0; event_id < BindingMask::MAX_EVENTS; ++event_id)
+        {
+            if (eventCounts[event_id])
+                mask->Remove(regtype, event_id, eventCounts[event_id]);
+            eventCounts[event_id] = 0;
+        }
+        liveBindings = 0;
+
+        for (auto& pair : bindings)
+            ReleaseAll(pair.second);
+        for (BindingList& list : dense_bindings)
+            ReleaseAll(list);
+        for (BindingList& list : entry_lists)
+            ReleaseAll(list);
+
         id_lookup_table.clear();
         bindings.clear();
+        dense_bindings.clear();
+        entry_bindings.clear();
+        entry_lists.clear();
+        entry_summary.Clear();
     }
 
     /*
@@ -137,22 +685,33 @@ public:
         if (iter == id_lookup_table.end())
             return;
 
-        BindingList* list = iter->second;
-        auto i = list->begin();
+        BindingLocation location = iter->second;
+        id_lookup_table.erase(iter);
 
-        for (; i != list->end(); ++i)
-        {
-            std::unique_ptr<Binding>& binding = *i;
-            if (binding->id == id)
-                break;
-        }
+        RemoveFromMask(location.event_id, location.entry);
+        luaL_unref(L, LUA_REGISTRYINDEX, location.list->Kill(location.slot));
+        CompactIfNeeded(*location.list);
+    }
+
+    /*
+     * Check whether this map holds any bindings at all.
+     */
+    bool HasAnyBindings() const
+    {
+        return liveBindings != 0;
+    }
 
-        if (i != list->end())
-            list->erase(i);
+    /*
+     * Check whether `entry` has bindings for any event.
+     *
+     * This is a single probe, instead of one lookup per event ID.
+     */
+    bool HasBindingsForEntry(uint32 entry)
+    {
+        static_assert(KeyTraits::by_entry, "HasBindingsForEntry requires an entry-indexed key");
 
-        // Unconditionally erase the ID in the lookup table because
-        //   it was either already invalid, or it's no longer valid.
-        id_lookup_table.erase(id);
+        uint32* summary = entry_summary.Find(entry);
+        return summary && *summary;
     }
 
     /*
@@ -160,15 +719,8 @@ public:
      */
     bool HasBindingsFor(const K& key)
     {
-        if (bindings.empty())
-            return false;
-
-        auto result = bindings.find(key);
-        if (result == bindings.end())
-            return false;
-
-        BindingList& list = result->second;
-        return !list.empty();
+        BindingList* list = Find(key);
+        return list && list->Live();
     }
 
     /*
@@ -176,32 +728,38 @@ public:
      */
     void PushRefsFor(const K& key)
     {
-        if (bindings.empty())
+        BindingList* result = Find(key);
+        if (!result)
             return;
 
-        auto result = bindings.find(key);
-        if (result == bindings.end())
-            return;
+        BindingList& list = *result;
+        bool expired = false;
 
-        BindingList& list = result->second;
-        for (auto i = list.begin(); i != list.end();)
+        for (uint32 slot = 0; slot < list.Size(); ++slot)
         {
-            std::unique_ptr<Binding>& binding = (*i);
-            auto i_prev = (i++);
+            if (list.IsTombstone(slot))
+                continue;
 
-            lua_rawgeti(L, LUA_REGISTRYINDEX, binding->functionReference);
+            lua_rawgeti(L, LUA_REGISTRYINDEX, list.Ref(slot));
 
-            if (binding->remainingShots > 0)
+            uint32& remainingShots = list.Shots(slot);
+            if (remainingShots > 0)
             {
-                binding->remainingShots -= 1;
+                remainingShots -= 1;
 
-                if (binding->remainingShots == 0)
+                if (remainingShots == 0)
                 {
-                    id_lookup_table.erase(binding->id);
-                    list.erase(i_prev);
+                    // The function stays alive on the stack after its reference is released.
+                    RemoveFromMask(key.event_id, EntryOf(key));
+                    id_lookup_table.erase(list.Id(slot));
+                    luaL_unref(L, LUA_REGISTRYINDEX, list.Kill(slot));
+                    expired = true;
                 }
             }
         }
+
+        if (expired)
+            CompactIfNeeded(list);
     }
 };
 
@@ -254,6 +812,87 @@ struct UniqueObjectKey
     { }
 };
 
+/*
+ * Upper bound (exclusive) of the IDs of each hook event enum.
+ */
+template<typename T> struct EventIdBound;
+
+#define FORGE_EVENT_ID_BOUND(EVENTS, COUNT) \
+    template<> struct EventIdBound<Hooks::EVENTS> { static constexpr std::size_t value = Hooks::COUNT; };\
+    static_assert(std::size_t(Hooks::COUNT) <= BindingMask::MAX_EVENTS, #EVENTS " does not fit in a BindingMask row")
+
+FORGE_EVENT_ID_BOUND(PacketEvents, PACKET_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(ServerEvents, SERVER_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(PlayerEvents, PLAYER_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(GuildEvents, GUILD_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(GroupEvents, GROUP_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(VehicleEvents, VEHICLE_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(CreatureEvents, CREATURE_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(GameObjectEvents, GAMEOBJECT_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(SpellEvents, SPELL_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(ItemEvents, ITEM_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(GossipEvents, GOSSIP_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(BGEvents, BG_EVENT_COUNT);
+FORGE_EVENT_ID_BOUND(InstanceEvents, INSTANCE_EVENT_COUNT);
+
+#undef FORGE_EVENT_ID_BOUND
+
+/*
+ * Describes whether a key type can be stored in a flat table, and how.
+ *
+ * Dense key types provide `size`, the number of table slots, `InRange`,
+ *   which rejects keys that fall outside of the table (e.g. IDs passed
+ *   from Lua to the Clear* functions), and `Index`, the slot of a key.
+ *
+ * Entry-indexed key types provide `size`, the number of event IDs, and
+ *   `InRange`, which rejects out of range event IDs.
+ */
+template<typename K>
+struct BindingKeyTraits
+{
+    static constexpr bool dense = false;
+    static constexpr bool by_entry = false;
+};
+
+template<typename T>
+struct BindingKeyTraits< EventKey<T> >
+{
+    static constexpr bool dense = true;
+    static constexpr bool by_entry = false;
+    static constexpr std::size_t size = EventIdBound<T>::value;
+
+    static bool InRange(EventKey<T> const& k) { return std::size_t(k.event_id) < size; }
+    static std::size_t Index(EventKey<T> const& k) { return std::size_t(k.event_id); }
+};
+
+template<>
+struct BindingKeyTraits< EntryKey<Hooks::PacketEvents> >
+{
+    static constexpr bool dense = true;
+    static constexpr bool by_entry = false;
+    static constexpr std::size_t size = std::size_t(Hooks::PACKET_EVENT_COUNT) * NUM_MSG_TYPES;
+
+    static bool InRange(EntryKey<Hooks::PacketEvents> const& k)
+    {
+        return std::size_t(k.event_id) < Hooks::PACKET_EVENT_COUNT && k.entry < NUM_MSG_TYPES;
+    }
+
+    static std::size_t Index(EntryKey<Hooks::PacketEvents> const& k)
+    {
+        return std::size_t(k.event_id) * NUM_MSG_TYPES + k.entry;
+    }
+};
+
+template<typename T>
+struct BindingKeyTraits< EntryKey<T> >
+{
+    static constexpr bool dense = false;
+    static constexpr bool by_entry = true;
+    static constexpr std::size_t size = EventIdBound<T>::value;
+
+    static bool InRange(EntryKey<T> const& k) { return std::size_t(k.event_id) < size; }
+};
+
 class hash_helper
 {
 public:
@@ -33,12 +33,24 @@ void ForgeConfig::Initialize()
     SetConfig(CONFIG_FORGE_COMPATIBILITY_MODE, "Forge.CompatibilityMode", false);
     SetConfig(CONFIG_FORGE_TRACEBACK, "Forge.TraceBack", false);
     SetConfig(CONFIG_FORGE_SCRIPT_RELOADER, "Forge.ScriptReloader", false);
+    SetConfig(CONFIG_FORGE_OBJECT_CACHE, "Forge.ObjectCache", false);
+    SetConfig(CONFIG_FORGE_BATCHED_OBJECT_TIMERS, "Forge.BatchedObjectTimers", false);
+    SetConfig(CONFIG_FORGE_METRICS, "Forge.Metrics", false);
 
     // Load strings
     SetConfig(CONFIG_FORGE_SCRIPT_PATH, "Forge.ScriptPath", "lua_scripts");
     SetConfig(CONFIG_FORGE_ONLY_ON_MAPS, "Forge.OnlyOnMaps", "");
     SetConfig(CONFIG_FORGE_REQUIRE_PATH_EXTRA, "Forge.RequirePaths", "");
     SetConfig(CONFIG_FORGE_REQUIRE_CPATH_EXTRA, "Forge.RequireCPaths", "");
+    SetConfig(CONFIG_FORGE_METRICS_FILE, "Forge.MetricsFile", "");
+    SetConfig(CONFIG_FORGE_BYTECODE_CACHE, "Forge.BytecodeCache", "");
+
+    // Load unsigned integers
+    SetConfig(CONFIG_FORGE_TICK_BUDGET, "Forge.TickBudgetMs", 0);
+    SetConfig(CONFIG_FORGE_WATCHDOG_INSTRUCTIONS, "Forge.WatchdogInstructions", 0);
+    SetConfig(CONFIG_FORGE_WATCHDOG_MS, "Forge.WatchdogMs", 0);
+    SetConfig(CONFIG_FORGE_METRICS_INTERVAL, "Forge.MetricsIntervalMs", 10000);
+    SetConfig(CONFIG_FORGE_SCRIPT_RELOADER_DELAY, "Forge.ScriptReloaderDelayMs", 500);
 
     // Call extra functions
     TokenizeAllowedMaps();
@@ -54,6 +66,11 @@ void ForgeConfig::SetConfig(ForgeConfigStringValues index, char const* fieldname
     SetConfig(index, sConfigMgr->GetStringDefault(fieldname, defvalue));
 }
 
+void ForgeConfig::SetConfig(ForgeConfigUIntValues index, char const* fieldname, uint32 defvalue)
+{
+    SetConfig(index, static_cast<uint32>(sConfigMgr->GetIntDefault(fieldname, defvalue)));
+}
+
 bool ForgeConfig::IsForgeEnabled()
 {
     return GetConfig(CONFIG_FORGE_ENABLED);
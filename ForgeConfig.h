@@ -20,6 +20,9 @@ enum ForgeConfigBoolValues
     CONFIG_FORGE_COMPATIBILITY_MODE,
     CONFIG_FORGE_TRACEBACK,
     CONFIG_FORGE_SCRIPT_RELOADER,
+    CONFIG_FORGE_OBJECT_CACHE,
+    CONFIG_FORGE_BATCHED_OBJECT_TIMERS,
+    CONFIG_FORGE_METRICS,
     CONFIG_FORGE_BOOL_COUNT
 };
 
@@ -29,9 +32,21 @@ enum ForgeConfigStringValues
     CONFIG_FORGE_ONLY_ON_MAPS,
     CONFIG_FORGE_REQUIRE_PATH_EXTRA,
     CONFIG_FORGE_REQUIRE_CPATH_EXTRA,
+    CONFIG_FORGE_METRICS_FILE,
+    CONFIG_FORGE_BYTECODE_CACHE,
     CONFIG_FORGE_STRING_COUNT
 };
 
+enum ForgeConfigUIntValues
+{
+    CONFIG_FORGE_TICK_BUDGET,
+    CONFIG_FORGE_WATCHDOG_INSTRUCTIONS,
+    CONFIG_FORGE_WATCHDOG_MS,
+    CONFIG_FORGE_METRICS_INTERVAL,
+    CONFIG_FORGE_SCRIPT_RELOADER_DELAY,
+    CONFIG_FORGE_UINT_COUNT
+};
+
 class ForgeConfig
 {
 private:
@@ -47,8 +62,10 @@ public:
 
     bool GetConfig(ForgeConfigBoolValues index) const { return _configBoolValues[index]; }
     const std::string& GetConfig(ForgeConfigStringValues index) const { return _configStringValues[index]; }
+    uint32 GetConfig(ForgeConfigUIntValues index) const { return _configUIntValues[index]; }
     void SetConfig(ForgeConfigBoolValues index, bool value) { _configBoolValues[index] = value; }
     void SetConfig(ForgeConfigStringValues index, std::string value) { _configStringValues[index] = value; }
+    void SetConfig(ForgeConfigUIntValues index, uint32 value) { _configUIntValues[index] = value; }
 
     bool IsForgeEnabled();
     bool IsForgeCompatibilityMode();
@@ -57,9 +74,11 @@ public:
 private:
     bool _configBoolValues[CONFIG_FORGE_BOOL_COUNT];
     std::string _configStringValues[CONFIG_FORGE_STRING_COUNT];
+    uint32 _configUIntValues[CONFIG_FORGE_UINT_COUNT];
 
     void SetConfig(ForgeConfigBoolValues index, char const* fieldname, bool defvalue);
     void SetConfig(ForgeConfigStringValues index, char const* fieldname, std::string defvalue);
+    void SetConfig(ForgeConfigUIntValues index, char const* fieldname, uint32 defvalue);
 
     void TokenizeAllowedMaps();
 
@@ -11,6 +11,8 @@
 
 #include "ForgeEventMgr.h"
 #include "LuaEngine.h"
+#include "ForgeConfig.h"
+#include "ForgeIncludes.h"
 #include "Object.h"
 
 extern "C"
@@ -19,7 +21,23 @@ extern "C"
 #include "lauxlib.h"
 };
 
-ForgeEventProcessor::ForgeEventProcessor(Forge* _F, WorldObject* _obj) : m_time(0), obj(_obj), F(_F)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit, `bits` must not be 0
+static inline uint32 LowestSetBit(uint64 bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+ForgeEventProcessor::ForgeEventProcessor(Forge* _F, WorldObject* _obj) : wheelTime(0), eventCount(0), m_time(0), obj(_obj), F(_F)
 {
     if (obj)
         F->eventMgr->processors.insert(this);
@@ -38,48 +56,257 @@ ForgeEventProcessor::~ForgeEventProcessor()
 void ForgeEventProcessor::Update(uint32 diff)
 {
     m_time += diff;
-    for (EventList::iterator it = eventList.begin(); it != eventList.end() && it->first <= m_time; it = eventList.begin())
+    while (wheelTime <= m_time)
     {
-        LuaEvent* luaEvent = it->second;
-        eventList.erase(it);
+        // Nothing is scheduled, the wheel can jump straight to the end of this update
+        if (!eventCount)
+        {
+            wheelTime = m_time + 1;
+            break;
+        }
+
+        uint64 tick = wheelTime;
+        if (!(tick & WHEEL_MASK))
+            Cascade(tick);
+
+        // Events scheduled while the slot runs are due at the next tick at the earliest
+        wheelTime = tick + 1;
+        RunSlot(tick);
+
+        // Skip the empty slots, but never past a block boundary or the current time
+        wheelTime = std::min(NextTick(tick), m_time + 1);
+    }
+}
+
+void ForgeEventProcessor::RunSlot(uint64 tick)
+{
+    WheelLevel* level = wheel[0].get();
+    if (!level)
+        return;
 
-        if (luaEvent->state != LUAEVENT_STATE_ERASE)
-            eventMap.erase(luaEvent->funcRef);
+    uint32 index = tick & WHEEL_MASK;
+    WheelSlot& slot = level->slots[index];
+    LuaEvent* luaEvent = slot.first;
+    slot.first = slot.last = NULL;
+    level->occupied &= ~(uint64(1) << index);
+
+    while (luaEvent)
+    {
+        LuaEvent* next = luaEvent->next;
+        --eventCount;
+
+        // Batched object timers are dropped once their object is no longer on the map
+        WorldObject* target = obj;
+        if (luaEvent->state == LUAEVENT_STATE_RUN && !luaEvent->guid.IsEmpty())
+        {
+            target = FindObject(luaEvent->guid);
+            if (!target)
+                luaEvent->SetState(LUAEVENT_STATE_ABORT);
+        }
 
         if (luaEvent->state == LUAEVENT_STATE_RUN)
         {
             uint32 delay = luaEvent->delay;
             bool remove = luaEvent->repeats == 1;
             if (!remove)
-                AddEvent(luaEvent); // Reschedule before calling incase RemoveEvents used
+            {
+                // Reschedule before calling incase RemoveEvents used
+                luaEvent->GenerateDelay();
+                luaEvent->due = m_time + luaEvent->delay;
+                Schedule(luaEvent);
+            }
+            else
+                UnmapEvent(luaEvent->funcRef);
 
             // Call the timed event
-            F->OnTimedEvent(luaEvent->funcRef, delay, luaEvent->repeats ? luaEvent->repeats-- : luaEvent->repeats, obj);
+            F->OnTimedEvent(luaEvent->funcRef, delay, luaEvent->repeats ? luaEvent->repeats-- : luaEvent->repeats, target);
 
-            if (!remove)
-                continue;
+            if (remove)
+                RemoveEvent(luaEvent);
+        }
+        else
+        {
+            // Event should be deleted (set to be aborted or erased)
+            if (luaEvent->state != LUAEVENT_STATE_ERASE)
+                UnmapEvent(luaEvent->funcRef);
+            RemoveEvent(luaEvent);
         }
 
-        // Event should be deleted (executed last time or set to be aborted)
-        RemoveEvent(luaEvent);
+        luaEvent = next;
     }
 }
 
+void ForgeEventProcessor::Cascade(uint64 tick)
+{
+    for (uint32 level = 1; level < WHEEL_LEVELS; ++level)
+    {
+        uint32 index = (tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+        if (WheelLevel* wheelLevel = wheel[level].get())
+        {
+            WheelSlot& slot = wheelLevel->slots[index];
+            LuaEvent* luaEvent = slot.first;
+            slot.first = slot.last = NULL;
+            wheelLevel->occupied &= ~(uint64(1) << index);
+
+            // Events of the slot are due within the next span of this level, move them down
+            while (luaEvent)
+            {
+                LuaEvent* next = luaEvent->next;
+                --eventCount;
+                Schedule(luaEvent);
+                luaEvent = next;
+            }
+        }
+
+        // The next level only moves when this one wrapped around
+        if (index)
+            break;
+    }
+}
+
+uint64 ForgeEventProcessor::NextTick(uint64 tick) const
+{
+    uint32 index = tick & WHEEL_MASK;
+    if (WheelLevel* level = wheel[0].get())
+    {
+        uint64 later = index < WHEEL_MASK ? level->occupied >> (index + 1) : 0;
+        if (later)
+            return tick + 1 + LowestSetBit(later);
+    }
+
+    // Start of the next block, where the higher levels are cascaded
+    return (tick | WHEEL_MASK) + 1;
+}
+
+WorldObject* ForgeEventProcessor::FindObject(ObjectGuid guid) const
+{
+    Map* map = F->GetBoundMap();
+    if (!map)
+        return NULL;
+
+    switch (guid.GetHigh())
+    {
+        case HIGHGUID_PLAYER:
+            return eObjectAccessor()GetPlayer(map, guid);
+        case HIGHGUID_TRANSPORT:
+        case HIGHGUID_MO_TRANSPORT:
+        case HIGHGUID_GAMEOBJECT:
+            return map->GetGameObject(guid);
+        case HIGHGUID_VEHICLE:
+        case HIGHGUID_UNIT:
+            return map->GetCreature(guid);
+        case HIGHGUID_PET:
+            return map->GetPet(guid);
+        case HIGHGUID_DYNAMICOBJECT:
+            return map->GetDynamicObject(guid);
+        case HIGHGUID_CORPSE:
+            return map->GetCorpse(guid);
+        default:
+            return NULL;
+    }
+}
+
+void ForgeEventProcessor::Schedule(LuaEvent* luaEvent)
+{
+    if (luaEvent->due < wheelTime)
+        luaEvent->due = wheelTime;
+
+    // Pick the lowest level whose span covers the remaining delay
+    uint64 delta = luaEvent->due - wheelTime;
+    uint32 level = 0;
+    while (level + 1 < WHEEL_LEVELS && delta >= (uint64(1) << (WHEEL_BITS * (level + 1))))
+        ++level;
+
+    if (!wheel[level])
+        wheel[level] = std::make_unique<WheelLevel>();
+
+    WheelLevel& wheelLevel = *wheel[level];
+    uint32 index = (luaEvent->due >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    WheelSlot& slot = wheelLevel.slots[index];
+
+    luaEvent->next = NULL;
+    if (slot.last)
+        slot.last->next = luaEvent;
+    else
+        slot.first = luaEvent;
+    slot.last = luaEvent;
+
+    wheelLevel.occupied |= uint64(1) << index;
+    ++eventCount;
+}
+
 void ForgeEventProcessor::SetStates(LuaEventState state)
 {
-    for (EventList::iterator it = eventList.begin(); it != eventList.end(); ++it)
+    // Every scheduled event that is not erased is in the event map
+    for (EventMap::iterator it = eventMap.begin(); it != eventMap.end(); ++it)
+    {
         it->second->SetState(state);
+        if (state == LUAEVENT_STATE_ERASE)
+            F->eventMgr->eventIndex.erase(it->first);
+    }
     if (state == LUAEVENT_STATE_ERASE)
+    {
         eventMap.clear();
+        objectEvents.clear();
+    }
+}
+
+void ForgeEventProcessor::SetStates(ObjectGuid guid, LuaEventState state)
+{
+    std::pair<ObjectEventMap::iterator, ObjectEventMap::iterator> range = objectEvents.equal_range(guid);
+    for (ObjectEventMap::iterator it = range.first; it != range.second; ++it)
+    {
+        EventMap::iterator event = eventMap.find(it->second);
+        if (event == eventMap.end())
+            continue;
+
+        event->second->SetState(state);
+        if (state == LUAEVENT_STATE_ERASE)
+        {
+            // erased events are not unreferenced when they are released
+            if (F->HasLuaState())
+                luaL_unref(F->L, LUA_REGISTRYINDEX, it->second);
+            eventMap.erase(event);
+            F->eventMgr->eventIndex.erase(it->second);
+        }
+    }
+    if (state == LUAEVENT_STATE_ERASE)
+        objectEvents.erase(range.first, range.second);
+}
+
+void ForgeEventProcessor::SetState(ObjectGuid guid, int eventId, LuaEventState state)
+{
+    // only touch the event if it belongs to the given object
+    EventMap::const_iterator it = eventMap.find(eventId);
+    if (it != eventMap.end() && it->second->guid == guid)
+        SetState(eventId, state);
 }
 
 void ForgeEventProcessor::RemoveEvents_internal()
 {
-    for (EventList::iterator it = eventList.begin(); it != eventList.end(); ++it)
-        RemoveEvent(it->second);
+    for (uint32 level = 0; level < WHEEL_LEVELS; ++level)
+    {
+        if (WheelLevel* wheelLevel = wheel[level].get())
+        {
+            for (uint32 index = 0; index < WHEEL_SLOTS; ++index)
+            {
+                LuaEvent* luaEvent = wheelLevel->slots[index].first;
+                while (luaEvent)
+                {
+                    LuaEvent* next = luaEvent->next;
+                    RemoveEvent(luaEvent);
+                    luaEvent = next;
+                }
+            }
+        }
+        wheel[level].reset();
+    }
 
-    eventList.clear();
+    eventCount = 0;
+    for (EventMap::iterator it = eventMap.begin(); it != eventMap.end(); ++it)
+        F->eventMgr->eventIndex.erase(it->first);
     eventMap.clear();
+    objectEvents.clear();
 }
 
 void ForgeEventProcessor::SetState(int eventId, LuaEventState state)
@@ -87,19 +314,52 @@ void ForgeEventProcessor::SetState(int eventId, LuaEventState state)
     if (eventMap.find(eventId) != eventMap.end())
         eventMap[eventId]->SetState(state);
     if (state == LUAEVENT_STATE_ERASE)
-        eventMap.erase(eventId);
+        UnmapEvent(eventId);
+}
+
+void ForgeEventProcessor::UnmapEvent(int eventId)
+{
+    // the index entry belongs to another processor if the event is not in this one
+    EventMap::iterator it = eventMap.find(eventId);
+    if (it == eventMap.end())
+        return;
+
+    ObjectGuid guid = it->second->guid;
+    if (!guid.IsEmpty())
+    {
+        std::pair<ObjectEventMap::iterator, ObjectEventMap::iterator> range = objectEvents.equal_range(guid);
+        for (ObjectEventMap::iterator event = range.first; event != range.second; ++event)
+        {
+            if (event->second == eventId)
+            {
+                objectEvents.erase(event);
+                break;
+            }
+        }
+    }
+
+    eventMap.erase(it);
+    F->eventMgr->eventIndex.erase(eventId);
 }
 
 void ForgeEventProcessor::AddEvent(LuaEvent* luaEvent)
 {
     luaEvent->GenerateDelay();
-    eventList.insert(std::pair<uint64, LuaEvent*>(m_time + luaEvent->delay, luaEvent));
+    luaEvent->due = m_time + luaEvent->delay;
+    Schedule(luaEvent);
     eventMap[luaEvent->funcRef] = luaEvent;
+    F->eventMgr->eventIndex[luaEvent->funcRef] = this;
 }
 
 void ForgeEventProcessor::AddEvent(int funcRef, uint32 min, uint32 max, uint32 repeats)
 {
-    AddEvent(new LuaEvent(funcRef, min, max, repeats));
+    AddEvent(F->eventMgr->AllocateEvent(funcRef, min, max, repeats, ObjectGuid()));
+}
+
+void ForgeEventProcessor::AddEvent(int funcRef, uint32 min, uint32 max, uint32 repeats, ObjectGuid guid)
+{
+    AddEvent(F->eventMgr->AllocateEvent(funcRef, min, max, repeats, guid));
+    objectEvents.emplace(guid, funcRef);
 }
 
 void ForgeEventProcessor::RemoveEvent(LuaEvent* luaEvent)
@@ -110,11 +370,14 @@ void ForgeEventProcessor::RemoveEvent(LuaEvent* luaEvent)
         // Free lua function ref
         luaL_unref(F->L, LUA_REGISTRYINDEX, luaEvent->funcRef);
     }
-    delete luaEvent;
+    F->eventMgr->ReleaseEvent(luaEvent);
 }
 
-EventMgr::EventMgr(Forge* _F) : globalProcessor(new ForgeEventProcessor(_F, NULL)), F(_F)
+EventMgr::EventMgr(Forge* _F) : globalProcessor(new ForgeEventProcessor(_F, NULL)), objectProcessor(NULL), F(_F), freeEvents(NULL)
 {
+    // object timers can only be batched in a map bound state, where objects can be found by guid
+    if (!F->GetCompatibilityMode() && F->GetBoundMap() && sForgeConfig->GetConfig(CONFIG_FORGE_BATCHED_OBJECT_TIMERS))
+        objectProcessor = new ForgeEventProcessor(F, NULL);
 }
 
 EventMgr::~EventMgr()
@@ -124,9 +387,37 @@ EventMgr::~EventMgr()
             for (ProcessorSet::const_iterator it = processors.begin(); it != processors.end(); ++it) // loop processors
                 (*it)->RemoveEvents_internal();
         globalProcessor->RemoveEvents_internal();
+        if (objectProcessor)
+            objectProcessor->RemoveEvents_internal();
     }
     delete globalProcessor;
     globalProcessor = NULL;
+    delete objectProcessor;
+    objectProcessor = NULL;
+
+    while (freeEvents)
+    {
+        LuaEvent* next = freeEvents->next;
+        delete freeEvents;
+        freeEvents = next;
+    }
+}
+
+LuaEvent* EventMgr::AllocateEvent(int funcRef, uint32 min, uint32 max, uint32 repeats, ObjectGuid guid)
+{
+    if (!freeEvents)
+        return new LuaEvent(funcRef, min, max, repeats, guid);
+
+    LuaEvent* luaEvent = freeEvents;
+    freeEvents = luaEvent->next;
+    *luaEvent = LuaEvent(funcRef, min, max, repeats, guid);
+    return luaEvent;
+}
+
+void EventMgr::ReleaseEvent(LuaEvent* luaEvent)
+{
+    luaEvent->next = freeEvents;
+    freeEvents = luaEvent;
 }
 
 void EventMgr::SetStates(LuaEventState state)
@@ -135,12 +426,20 @@ void EventMgr::SetStates(LuaEventState state)
         for (ProcessorSet::const_iterator it = processors.begin(); it != processors.end(); ++it) // loop processors
             (*it)->SetStates(state);
     globalProcessor->SetStates(state);
+    if (objectProcessor)
+        objectProcessor->SetStates(state);
+}
+
+void EventMgr::RemoveObjectEvents(ObjectGuid guid)
+{
+    if (objectProcessor)
+        objectProcessor->SetStates(guid, LUAEVENT_STATE_ERASE);
 }
 
 void EventMgr::SetState(int eventId, LuaEventState state)
 {
-    if (!processors.empty())
-        for (ProcessorSet::const_iterator it = processors.begin(); it != processors.end(); ++it) // loop processors
-            (*it)->SetState(eventId, state);
-    globalProcessor->SetState(eventId, state);
+    // event IDs are unique within the Lua state, so only one processor can have it
+    EventIndex::const_iterator it = eventIndex.find(eventId);
+    if (it != eventIndex.end())
+        it->second->SetState(eventId, state);
 }
@@ -16,6 +16,7 @@
 #include "Common.h"
 #include "Random.h"
 #include <map>
+#include <memory>
 
 #include "Define.h"
 
@@ -33,8 +34,8 @@ enum LuaEventState
 
 struct LuaEvent
 {
-    LuaEvent(int _funcRef, uint32 _min, uint32 _max, uint32 _repeats) :
-        min(_min), max(_max), delay(0), repeats(_repeats), funcRef(_funcRef), state(LUAEVENT_STATE_RUN)
+    LuaEvent(int _funcRef, uint32 _min, uint32 _max, uint32 _repeats, ObjectGuid _guid = ObjectGuid()) :
+        min(_min), max(_max), delay(0), repeats(_repeats), funcRef(_funcRef), state(LUAEVENT_STATE_RUN), due(0), next(NULL), guid(_guid)
     {
     }
 
@@ -55,15 +56,27 @@ struct LuaEvent
     uint32 repeats; // Amount of repeats to make, 0 for infinite
     int funcRef;    // Lua function reference ID, also used as event ID
     LuaEventState state;    // State for next call
+    uint64 due;     // Processor time at which the event is called next
+    LuaEvent* next; // Next event in the same timer wheel slot or in the free list of EventMgr
+    ObjectGuid guid; // Object the event belongs to when batched in EventMgr::objectProcessor, otherwise empty
 };
 
+/*
+ * Keeps the timed events of one object (or the global ones) in a hierarchical timer wheel.
+ *
+ * Level 0 has one slot per millisecond of the current 64 ms block, each higher level
+ *   has 64 slots that are 64 times wider than the slots of the level below.
+ *   When the wheel reaches a block boundary the due slot of the next level is cascaded
+ *   down, so adding, rescheduling and running an event is O(1) and `Update` only visits
+ *   occupied slots and block boundaries.
+ */
 class ForgeEventProcessor
 {
     friend class EventMgr;
 
 public:
-    typedef std::multimap<uint64, LuaEvent*> EventList;
     typedef std::unordered_map<int, LuaEvent*> EventMap;
+    typedef std::unordered_multimap<ObjectGuid, int> ObjectEventMap;
 
     ForgeEventProcessor(Forge* _F, WorldObject* _obj);
     ~ForgeEventProcessor();
@@ -74,13 +87,50 @@ public:
     // set the event to be removed when executing
     void SetState(int eventId, LuaEventState state);
     void AddEvent(int funcRef, uint32 min, uint32 max, uint32 repeats);
+
+    // Batched object timers, the object is looked up by guid on the bound map when the event is due
+    void AddEvent(int funcRef, uint32 min, uint32 max, uint32 repeats, ObjectGuid guid);
+    // Erasing also frees the function references, the events are released when their slot comes due
+    void SetStates(ObjectGuid guid, LuaEventState state);
+    void SetState(ObjectGuid guid, int eventId, LuaEventState state);
     EventMap eventMap;
 
 private:
+    static constexpr uint32 WHEEL_BITS = 6;
+    static constexpr uint32 WHEEL_SLOTS = 1 << WHEEL_BITS;
+    static constexpr uint32 WHEEL_MASK = WHEEL_SLOTS - 1;
+    // Enough levels to hold the largest uint32 delay plus the time passed in one update
+    static constexpr uint32 WHEEL_LEVELS = 6;
+
+    struct WheelSlot
+    {
+        LuaEvent* first;
+        LuaEvent* last;
+    };
+
+    struct WheelLevel
+    {
+        uint64 occupied; // Bit per non empty slot
+        WheelSlot slots[WHEEL_SLOTS];
+    };
+
     void RemoveEvents_internal();
     void AddEvent(LuaEvent* luaEvent);
     void RemoveEvent(LuaEvent* luaEvent);
-    EventList eventList;
+    void UnmapEvent(int eventId);
+    void Schedule(LuaEvent* luaEvent);
+    void Cascade(uint64 tick);
+    void RunSlot(uint64 tick);
+    uint64 NextTick(uint64 tick) const;
+    WorldObject* FindObject(ObjectGuid guid) const;
+
+    // Levels are allocated on first use, most objects only use the lowest few
+    std::unique_ptr<WheelLevel> wheel[WHEEL_LEVELS];
+    // The next tick of the wheel to run, every event is due at this tick or later
+    uint64 wheelTime;
+    uint32 eventCount;
+    // Event IDs of the batched object timers, by object guid
+    ObjectEventMap objectEvents;
     uint64 m_time;
     WorldObject* obj;
     Forge* F;
@@ -90,13 +140,22 @@ class EventMgr
 {
 public:
     typedef std::unordered_set<ForgeEventProcessor*> ProcessorSet;
+    typedef std::unordered_map<int, ForgeEventProcessor*> EventIndex;
     ProcessorSet processors;
     ForgeEventProcessor* globalProcessor;
+    // Holds the timers of all objects of the bound map when Forge.BatchedObjectTimers is enabled, NULL otherwise
+    ForgeEventProcessor* objectProcessor;
+    // Processor of every event that is in the eventMap of a processor, by event ID
+    EventIndex eventIndex;
     Forge* F;
 
     EventMgr(Forge* _F);
     ~EventMgr();
 
+    // Returns a pooled event, released events are kept for reuse until the manager is destroyed
+    LuaEvent* AllocateEvent(int funcRef, uint32 min, uint32 max, uint32 repeats, ObjectGuid guid);
+    void ReleaseEvent(LuaEvent* luaEvent);
+
     // Set the state of all timed events
     // Execute only in safe env
     void SetStates(LuaEventState state);
@@ -104,6 +163,12 @@ public:
     // Sets the eventId's state in all processors
     // Execute only in safe env
     void SetState(int eventId, LuaEventState state);
+
+    // Erases the batched timers of an object that leaves the bound map, like its own processor would be
+    void RemoveObjectEvents(ObjectGuid guid);
+
+private:
+    LuaEvent* freeEvents;
 };
 
 #endif
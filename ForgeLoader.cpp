@@ -9,6 +9,7 @@
 #include "ForgeConfig.h"
 #include "ForgeLoader.h"
 #include "ForgeUtility.h"
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <thread>
@@ -41,10 +42,10 @@ void ForgeUpdateListener::handleFileAction(efsw::WatchID /*watchid*/, std::strin
     if (ext != ".lua" && ext != ".ext" && ext != ".moon")
         return;
 
-    sForgeLoader->ReloadForgeForMap(RELOAD_ALL_STATES);
+    sForgeLoader->RequestFileReload();
 }
 
-ForgeLoader::ForgeLoader() : m_cacheState(SCRIPT_CACHE_NONE)
+ForgeLoader::ForgeLoader() : m_cacheState(SCRIPT_CACHE_NONE), m_lastLoadTime(0), m_stopCoordinator(false), m_fileEvents(0), m_fileReloads(0)
 {
     lua_scriptWatcher = -1;
 }
@@ -61,6 +62,16 @@ ForgeLoader::~ForgeLoader()
     if (m_reloadThread.joinable())
         m_reloadThread.join();
 
+    if (m_coordinatorThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_coordinatorLock);
+            m_stopCoordinator = true;
+        }
+        m_coordinatorCondition.notify_one();
+        m_coordinatorThread.join();
+    }
+
     if (lua_scriptWatcher >= 0)
     {
         lua_fileWatcher.removeWatch(lua_scriptWatcher);
@@ -70,8 +81,9 @@ ForgeLoader::~ForgeLoader()
 
 void ForgeLoader::ReloadScriptCache()
 {
-    // if the internal cache state is anything other than ready, we return
-    if (m_cacheState != SCRIPT_CACHE_READY)
+    // if the internal cache state is anything other than ready, we return, otherwise set it to reinit
+    uint8 ready = SCRIPT_CACHE_READY;
+    if (!m_cacheState.compare_exchange_strong(ready, SCRIPT_CACHE_REINIT))
     {
         FORGE_LOG_DEBUG("[Forge]: Script cache not ready, skipping reload");
         return;
@@ -81,9 +93,6 @@ void ForgeLoader::ReloadScriptCache()
     if (m_reloadThread.joinable())
         m_reloadThread.join();
 
-    // set the internal cache state to reinit
-    m_cacheState = SCRIPT_CACHE_REINIT;
-
     // create new thread to load scripts asynchronously
     m_reloadThread = std::thread(&ForgeLoader::LoadScripts, this);
     FORGE_LOG_DEBUG("[Forge]: Script cache reload thread started");
@@ -112,19 +121,16 @@ void ForgeLoader::LoadScripts()
 
     FORGE_LOG_INFO("[Forge]: Searching for scripts in `%s`", lua_folderpath.c_str());
 
-    // open a new temporary Lua state to compile bytecode in
-    lua_State* L = luaL_newstate();
-    luaL_openlibs(L);
-
     // clear all cache variables
     m_requirePath.clear();
     m_requirecPath.clear();
 
-    // read and compile all scripts
-    ReadFiles(L, lua_folderpath);
-
-    // close temporary Lua state
-    lua_close(L);
+    // find all scripts, then compile them on all cores
+    m_previousCache = GetScriptCache();
+    ReadFiles(lua_folderpath);
+    uint32 found = uint32(m_pending.size());
+    uint32 cacheHits = CompileScripts();
+    m_previousCache.reset();
 
     // combine lists of Lua scripts and extensions
     CombineLists();
@@ -143,7 +149,12 @@ void ForgeLoader::LoadScripts()
     if (!m_requirecPath.empty())
         m_requirecPath.erase(m_requirecPath.end() - 1);
 
-    FORGE_LOG_INFO("[Forge]: Loaded and precompiled %u scripts in %u ms", uint32(m_scriptCache.size()), ForgeUtil::GetTimeDiff(oldMSTime));
+    m_lastLoadTime = ForgeUtil::GetTimeDiff(oldMSTime);
+    if (sForgeConfig->GetConfig(CONFIG_FORGE_BYTECODE_CACHE).empty())
+        FORGE_LOG_INFO("[Forge]: Loaded and precompiled %u scripts in %u ms", uint32(GetScriptCache()->scripts.size()), uint32(m_lastLoadTime));
+    else
+        FORGE_LOG_INFO("[Forge]: Loaded and precompiled %u scripts in %u ms, %u of %u from the bytecode cache (%u%%)", uint32(GetScriptCache()->scripts.size()), uint32(m_lastLoadTime),
+            cacheHits, found, found ? cacheHits * 100 / found : 0);
 
     // set the cache state to ready
     m_cacheState = SCRIPT_CACHE_READY;
@@ -157,7 +168,7 @@ int ForgeLoader::LoadBytecodeChunk(lua_State* /*L*/, uint8* bytes, size_t len, B
 }
 
 // Finds lua script files from given path (including subdirectories) and pushes them to scripts
-void ForgeLoader::ReadFiles(lua_State* L, std::string path)
+void ForgeLoader::ReadFiles(std::string path)
 {
     std::string lua_folderpath = sForgeConfig->GetConfig(CONFIG_FORGE_SCRIPT_PATH);
 
@@ -194,7 +205,7 @@ void ForgeLoader::ReadFiles(lua_State* L, std::string path)
             // load subfolder
             if (fs::is_directory(dir_iter->status()))
             {
-                ReadFiles(L, fullpath);
+                ReadFiles(fullpath);
                 continue;
             }
 
@@ -210,20 +221,21 @@ void ForgeLoader::ReadFiles(lua_State* L, std::string path)
                 // convert subfolder name to an integer
                 auto [ptr, ec] = std::from_chars(subfolder.data(), subfolder.data() + subfolder.size(), mapId);
 
-                // default to all maps on invalid map id or map id less than -1
-                if (ec == std::errc::invalid_argument || ec == std::errc::result_out_of_range || mapId < -1)
+                // default to all maps unless the whole top level folder name is a valid map id, files like `00_init.lua` are not tagged
+                if (ec != std::errc() || ptr == subfolder.data() + subfolder.size() || *ptr != '/' || mapId < -1)
                     mapId = -1;
 
                 // was file, try add
                 std::string filename = dir_iter->path().filename().generic_string();
                 size_t filesize = fs::file_size(dir_iter->path());
-                ProcessScript(L, filename, filesize, fullpath, mapId);
+                ProcessScript(filename, filesize, fullpath, mapId);
             }
         }
     }
 }
 
-bool ForgeLoader::CompileScript(lua_State* L, LuaScript& script)
+// Runs on the compile threads, errors are returned to be logged in order by CompileScripts
+bool ForgeLoader::CompileScript(lua_State* L, LuaScript& script, std::string& error)
 {
     // Attempt to load the file
     int err = 0;
@@ -237,8 +249,9 @@ bool ForgeLoader::CompileScript(lua_State* L, LuaScript& script)
     // If something bad happened, try to find an error.
     if (err != 0)
     {
-        FORGE_LOG_ERROR("[Forge]: CompileScript failed to load the Lua script `%s`.", script.filename.c_str());
-        Forge::Report(L);
+        const char* msg = lua_tostring(L, -1);
+        error = "failed to load the Lua script `" + script.filename + "`.\n" + (msg ? msg : "unknown error");
+        lua_pop(L, 1);
         return false;
     }
     FORGE_LOG_DEBUG("[Forge]: CompileScript loaded Lua script `%s`", script.filename.c_str());
@@ -247,8 +260,8 @@ bool ForgeLoader::CompileScript(lua_State* L, LuaScript& script)
     err = lua_dump(L, (lua_Writer)LoadBytecodeChunk, &script.bytecode);
     if (err || script.bytecode.empty())
     {
-        FORGE_LOG_ERROR("[Forge]: CompileScript failed to dump the Lua script `%s` to bytecode.", script.filename.c_str());
-        Forge::Report(L);
+        error = "failed to dump the Lua script `" + script.filename + "` to bytecode.";
+        lua_pop(L, 1);
         return false;
     }
     FORGE_LOG_DEBUG("[Forge]: CompileScript dumped Lua script `%s` to bytecode.", script.filename.c_str());
@@ -258,7 +271,7 @@ bool ForgeLoader::CompileScript(lua_State* L, LuaScript& script)
     return true;
 }
 
-void ForgeLoader::ProcessScript(lua_State* L, std::string filename, const size_t& filesize, const std::string& fullpath, int32 mapId)
+void ForgeLoader::ProcessScript(std::string filename, const size_t& filesize, const std::string& fullpath, int32 mapId)
 {
     FORGE_LOG_DEBUG("[Forge]: ProcessScript checking file `%s`", fullpath.c_str());
 
@@ -272,7 +285,6 @@ void ForgeLoader::ProcessScript(lua_State* L, std::string filename, const size_t
     // check extension and add path to scripts to load
     if (ext != ".lua" && ext != ".ext" && ext != ".moon")
         return;
-    bool extension = ext == ".ext";
 
     LuaScript script;
     script.fileext = ext;
@@ -281,17 +293,272 @@ void ForgeLoader::ProcessScript(lua_State* L, std::string filename, const size_t
     script.modulepath = fullpath.substr(0, fullpath.length() - filename.length() - ext.length());
     script.bytecode.reserve(filesize);
     script.mapId = mapId;
+    script.fileSize = filesize;
+    script.sourceHash = 0;
+    script.hash = 0;
 
-    // if compilation fails, we don't add the script 
-    if (!CompileScript(L, script))
-        return;
+    // compiled by CompileScripts
+    m_pending.push_back(std::move(script));
+}
 
-    if (extension)
-        m_extensions.push_back(script);
-    else
-        m_scripts.push_back(script);
+// The bytecode of a script is only taken from the cache if all of these match
+struct BytecodeCacheKey
+{
+    uint64 size;
+    int64 mtime;
+    uint64 hash;
+};
+
+// Bytecode can only be loaded by the Lua it was dumped with, LuaJIT 2.0 and 2.1 share the same LUA_RELEASE
+#if defined LUAJIT_VERSION
+static const char* const bytecodeRuntime = LUA_RELEASE " " LUAJIT_VERSION;
+#else
+static const char* const bytecodeRuntime = LUA_RELEASE;
+#endif
+
+static uint64 HashBytes(const char* bytes, size_t len, uint64 hash = 14695981039346656037ULL)
+{
+    // FNV-1a
+    for (size_t i = 0; i < len; ++i)
+    {
+        hash ^= static_cast<uint8>(bytes[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool GetBytecodeCacheKey(const std::string& filepath, BytecodeCacheKey& key)
+{
+    boost::system::error_code ec;
+    key.size = fs::file_size(filepath, ec);
+    if (ec)
+        return false;
+    key.mtime = static_cast<int64>(fs::last_write_time(filepath, ec));
+    if (ec)
+        return false;
+
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file)
+        return false;
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    key.hash = HashBytes(content.data(), content.size());
+    return true;
+}
+
+// One cache file per script, named after the hash of its path
+static std::string GetBytecodeCachePath(const std::string& cacheDir, const std::string& filepath)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.luac", static_cast<unsigned long long>(HashBytes(filepath.data(), filepath.size())));
+    return cacheDir + "/" + name;
+}
+
+static bool LoadCachedBytecode(const std::string& cachePath, LuaScript& script, const BytecodeCacheKey& key)
+{
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file)
+        return false;
 
-    FORGE_LOG_DEBUG("[Forge]: ProcessScript processed `%s` successfully", fullpath.c_str());
+    // Header: runtime, size_t size, script path, then the key and the bytecode size
+    std::string runtime, filepath;
+    size_t pointerSize = 0, bytecodeSize = 0;
+    BytecodeCacheKey cached = BytecodeCacheKey();
+    if (!std::getline(file, runtime) || runtime != bytecodeRuntime)
+        return false;
+    if (!(file >> pointerSize) || pointerSize != sizeof(size_t) || !file.ignore() || !std::getline(file, filepath) || filepath != script.filepath)
+        return false;
+    if (!(file >> cached.size >> cached.mtime >> cached.hash >> bytecodeSize) || !file.ignore())
+        return false;
+    if (cached.size != key.size || cached.mtime != key.mtime || cached.hash != key.hash || !bytecodeSize)
+        return false;
+
+    script.bytecode.resize(bytecodeSize);
+    if (!file.read(reinterpret_cast<char*>(&script.bytecode[0]), bytecodeSize))
+    {
+        script.bytecode.clear();
+        return false;
+    }
+    return true;
+}
+
+static void StoreCachedBytecode(const std::string& cachePath, LuaScript const& script, const BytecodeCacheKey& key)
+{
+    // written to a temporary file first, so a half written file is never loaded
+    std::string temp = cachePath + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        file << bytecodeRuntime << '\n' << sizeof(size_t) << '\n' << script.filepath << '\n'
+            << key.size << ' ' << key.mtime << ' ' << key.hash << ' ' << script.bytecode.size() << '\n';
+        file.write(reinterpret_cast<const char*>(&script.bytecode[0]), script.bytecode.size());
+        if (!file)
+            return;
+    }
+
+    boost::system::error_code ec;
+    fs::rename(temp, cachePath, ec);
+    if (ec)
+        FORGE_LOG_ERROR("[Forge]: Could not write the bytecode cache file `%s` of `%s`", cachePath.c_str(), script.filepath.c_str());
+}
+
+uint32 ForgeLoader::CompileScripts()
+{
+    if (m_pending.empty())
+        return 0;
+    uint32 total = uint32(m_pending.size());
+
+    // scripts that did not change since they were last compiled are loaded from the bytecode cache
+    std::string cacheDir = sForgeConfig->GetConfig(CONFIG_FORGE_BYTECODE_CACHE);
+    if (!cacheDir.empty())
+    {
+        boost::system::error_code ec;
+        fs::create_directories(cacheDir, ec);
+        if (ec)
+        {
+            FORGE_LOG_ERROR("[Forge]: Could not create the bytecode cache folder `%s`, scripts are compiled without it", cacheDir.c_str());
+            cacheDir.clear();
+        }
+    }
+
+    std::vector<std::string> errors(m_pending.size());
+    std::vector<uint8> compiled(m_pending.size(), 0);
+    std::atomic<size_t> next(0);
+    std::atomic<uint32> cacheHits(0);
+    std::atomic<uint32> unchanged(0);
+
+    // every worker compiles in its own temporary Lua state, taking the next script until none are left
+    auto worker = [this, &cacheDir, &errors, &compiled, &next, &cacheHits, &unchanged]()
+    {
+        lua_State* L = luaL_newstate();
+        luaL_openlibs(L);
+        for (size_t i = next++; i < m_pending.size(); i = next++)
+        {
+            LuaScript& script = m_pending[i];
+
+            BytecodeCacheKey key;
+            bool hashed = GetBytecodeCacheKey(script.filepath, key);
+            if (hashed)
+                script.sourceHash = key.hash;
+
+            // on a reload only the files whose content changed since the last load are compiled,
+            // the modification time is not compared as it can stay the same for a quick edit or a copy
+            if (m_previousCache && hashed)
+            {
+                auto previous = m_previousCache->index.find(script.filename);
+                if (previous != m_previousCache->index.end() && previous->second->filepath == script.filepath &&
+                    previous->second->fileSize == key.size && previous->second->sourceHash == key.hash)
+                {
+                    script.bytecode = previous->second->bytecode;
+                    script.hash = previous->second->hash;
+                    ++unchanged;
+                    compiled[i] = 1;
+                    continue;
+                }
+            }
+
+            bool useCache = hashed && !cacheDir.empty();
+            std::string cachePath = useCache ? GetBytecodeCachePath(cacheDir, script.filepath) : std::string();
+
+            if (useCache && LoadCachedBytecode(cachePath, script, key))
+                ++cacheHits;
+            else
+            {
+                if (!CompileScript(L, script, errors[i]))
+                    continue;
+                if (useCache)
+                    StoreCachedBytecode(cachePath, script, key);
+            }
+
+            script.hash = HashBytes(reinterpret_cast<const char*>(&script.bytecode[0]), script.bytecode.size());
+            compiled[i] = 1;
+        }
+        lua_close(L);
+    };
+
+    size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), m_pending.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i)
+        workers.emplace_back(worker);
+    worker();
+    for (std::thread& thread : workers)
+        thread.join();
+
+    // merge in the order the files were found, so errors are logged as if the scripts were compiled one by one
+    for (size_t i = 0; i < m_pending.size(); ++i)
+    {
+        LuaScript& script = m_pending[i];
+
+        // if compilation fails, we don't add the script
+        if (!compiled[i])
+        {
+            FORGE_LOG_ERROR("[Forge]: CompileScript %s", errors[i].c_str());
+            continue;
+        }
+        FORGE_LOG_DEBUG("[Forge]: ProcessScript processed `%s` successfully", script.filepath.c_str());
+
+        if (script.fileext == ".ext")
+            m_extensions.push_back(std::move(script));
+        else
+            m_scripts.push_back(std::move(script));
+    }
+    m_pending.clear();
+
+    if (m_previousCache)
+        FORGE_LOG_DEBUG("[Forge]: Compiled %u changed scripts, %u did not change", total - unchanged, uint32(unchanged));
+    return cacheHits;
+}
+
+void ForgeLoader::RequestFileReload()
+{
+    // only timestamps the change, the coordinator thread does the reload so the watcher thread never waits
+    {
+        std::lock_guard<std::mutex> guard(m_coordinatorLock);
+        ++m_fileEvents;
+        m_lastFileEvent = std::chrono::steady_clock::now();
+    }
+    m_coordinatorCondition.notify_one();
+}
+
+void ForgeLoader::ReloadCoordinator()
+{
+    std::unique_lock<std::mutex> guard(m_coordinatorLock);
+    while (!m_stopCoordinator)
+    {
+        if (!m_fileEvents)
+        {
+            m_coordinatorCondition.wait(guard);
+            continue;
+        }
+
+        // wait until the files stopped changing, every new change restarts the quiet period
+        std::chrono::steady_clock::time_point quietUntil = m_lastFileEvent + std::chrono::milliseconds(sForgeConfig->GetConfig(CONFIG_FORGE_SCRIPT_RELOADER_DELAY));
+        if (std::chrono::steady_clock::now() < quietUntil)
+        {
+            m_coordinatorCondition.wait_until(guard, quietUntil);
+            continue;
+        }
+
+        // a reload started by `.reload forge` is still running, the changes are picked up after it
+        uint8 ready = SCRIPT_CACHE_READY;
+        if (!m_cacheState.compare_exchange_strong(ready, SCRIPT_CACHE_REINIT))
+        {
+            m_coordinatorCondition.wait_for(guard, std::chrono::milliseconds(100));
+            continue;
+        }
+
+        uint32 events = m_fileEvents;
+        m_fileEvents = 0;
+
+        // files that change while compiling are counted again and reloaded after the quiet period
+        guard.unlock();
+        FORGE_LOG_DEBUG("[Forge]: Reloading the script cache after %u file changes", events);
+        LoadScripts();
+
+        // the states reload the scripts that changed on their next update, see Forge::ScriptsChanged
+        ++m_fileReloads;
+        guard.lock();
+    }
 }
 
 void ForgeLoader::InitializeFileWatcher()
@@ -309,6 +576,9 @@ void ForgeLoader::InitializeFileWatcher()
     }
 
     lua_fileWatcher.watch();
+
+    if (!m_coordinatorThread.joinable())
+        m_coordinatorThread = std::thread(&ForgeLoader::ReloadCoordinator, this);
 }
 
 static bool ScriptPathComparator(const LuaScript& first, const LuaScript& second)
@@ -321,14 +591,32 @@ void ForgeLoader::CombineLists()
     m_extensions.sort(ScriptPathComparator);
     m_scripts.sort(ScriptPathComparator);
 
-    m_scriptCache.clear();
-    m_scriptCache.reserve(m_extensions.size() + m_scripts.size());
+    std::shared_ptr<LuaScriptCache> cache = std::make_shared<LuaScriptCache>();
+    // the index points into the vector, it must not reallocate
+    cache->scripts.reserve(m_extensions.size() + m_scripts.size());
+    cache->index.reserve(m_extensions.size() + m_scripts.size());
+
+    for (std::list<LuaScript>* list : { &m_extensions, &m_scripts })
+    {
+        for (LuaScript& script : *list)
+        {
+            // Check that no duplicate names exist, require can only find one of them
+            auto existing = cache->index.find(script.filename);
+            if (existing != cache->index.end())
+            {
+                FORGE_LOG_ERROR("[Forge]: Error loading `%s`. File with same name already loaded from `%s`, rename either file", script.filepath.c_str(), existing->second->filepath.c_str());
+                continue;
+            }
 
-    std::move(m_extensions.begin(), m_extensions.end(), std::back_inserter(m_scriptCache));
-    std::move(m_scripts.begin(), m_scripts.end(), std::back_inserter(m_scriptCache));
+            cache->scripts.push_back(std::move(script));
+            cache->index.emplace(cache->scripts.back().filename, &cache->scripts.back());
+        }
+    }
 
     m_extensions.clear();
     m_scripts.clear();
+
+    std::atomic_store(&m_scriptCache, std::shared_ptr<const LuaScriptCache>(std::move(cache)));
 }
 
 void ForgeLoader::ReloadForgeForMap(int mapId)
@@ -352,3 +640,18 @@ void ForgeLoader::ReloadForgeForMap(int mapId)
         );
     }
 }
+
+void ForgeLoader::RequestProfileForMap(ForgeProfileRequest request, int mapId)
+{
+    if (mapId == RELOAD_GLOBAL_STATE || mapId == RELOAD_ALL_STATES)
+        if (Forge* f = sWorld->GetForge())
+            f->RequestProfile(request);
+
+    sMapMgr->DoForAllMaps([&](Map* map)
+        {
+            if (mapId == RELOAD_ALL_STATES || mapId == static_cast<int>(map->GetId()))
+                if (Forge* f = map->GetForge())
+                    f->RequestProfile(request);
+        }
+    );
+}
@@ -11,6 +11,7 @@
 #include "LuaEngine.h"
 
 #include <efsw/efsw.hpp>
+#include <condition_variable>
 
 extern "C"
 {
@@ -50,9 +51,21 @@ public:
 
     void LoadScripts();
     void ReloadForgeForMap(int mapId);
+    // Passes a `.forge profile`, `.forge sample` or `.forge stats` request to the states of `mapId` like ReloadForgeForMap,
+    // each handles it on its next update
+    void RequestProfileForMap(ForgeProfileRequest request, int mapId);
+
+    // Called by the file watcher for every changed script, bursts of changes are merged into one reload
+    // of the script cache once no file changed for Forge.ScriptReloaderDelayMs
+    void RequestFileReload();
+    // Increased every time the file watcher reloaded the script cache, the states then reload the scripts that changed
+    uint32 GetFileReloadCount() const { return m_fileReloads; }
 
     uint8 GetCacheState() const { return m_cacheState; }
-    const std::vector<LuaScript>& GetLuaScripts() const { return m_scriptCache; }
+    // Milliseconds the last load of the script cache took
+    uint32 GetLastLoadTime() const { return m_lastLoadTime; }
+    // The latest script cache, NULL until the scripts are loaded the first time
+    std::shared_ptr<const LuaScriptCache> GetScriptCache() const { return std::atomic_load(&m_scriptCache); }
     const std::string& GetRequirePath() const { return m_requirePath; }
     const std::string& GetRequireCPath() const { return m_requirecPath; }
 
@@ -63,19 +76,37 @@ public:
 
 private:
     void ReloadScriptCache();
-    void ReadFiles(lua_State* L, std::string path);
+    void ReadFiles(std::string path);
+    // Returns the amount of scripts that were loaded from the bytecode cache instead of being compiled
+    uint32 CompileScripts();
     void CombineLists();
-    void ProcessScript(lua_State* L, std::string filename, const size_t& filesize, const std::string& fullpath, int32 mapId);
-    bool CompileScript(lua_State* L, LuaScript& script);
+    void ProcessScript(std::string filename, const size_t& filesize, const std::string& fullpath, int32 mapId);
+    bool CompileScript(lua_State* L, LuaScript& script, std::string& error);
+    // The cache being replaced by LoadScripts, scripts that did not change are copied from it instead of being compiled
+    std::shared_ptr<const LuaScriptCache> m_previousCache;
     static int LoadBytecodeChunk(lua_State* L, uint8* bytes, size_t len, BytecodeBuffer* buffer);
 
     std::atomic<uint8> m_cacheState;
-    std::vector<LuaScript> m_scriptCache;
+    std::atomic<uint32> m_lastLoadTime;
+    // Replaced as a whole by every load, states keep the cache they were opened with
+    std::shared_ptr<const LuaScriptCache> m_scriptCache;
     std::string m_requirePath;
     std::string m_requirecPath;
+    // Scripts found by ReadFiles, in the order they were found, waiting for CompileScripts
+    std::vector<LuaScript> m_pending;
     std::list<LuaScript> m_scripts;
     std::list<LuaScript> m_extensions;
     std::thread m_reloadThread;
+
+    // Reloads of the script cache requested by the file watcher, see RequestFileReload
+    void ReloadCoordinator();
+    std::thread m_coordinatorThread;
+    std::mutex m_coordinatorLock;
+    std::condition_variable m_coordinatorCondition;
+    bool m_stopCoordinator;
+    uint32 m_fileEvents;
+    std::chrono::steady_clock::time_point m_lastFileEvent;
+    std::atomic<uint32> m_fileReloads;
 };
 
 /// File watcher responsible for watching lua scripts
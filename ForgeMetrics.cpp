@@ -0,0 +1,115 @@
+/*
+ * Part of Forge <https://github.com/iThorgrim/Forge>, a standalone fork of Eluna Lua Engine.
+ *
+ * Copyright (C) Forge contributors
+ * Based on Eluna <https://elunaluaengine.github.io/>
+ * Copyright (C) Eluna Lua Engine contributors
+ *
+ * Licensed under the GNU GPL v3 only.
+ * See LICENSE file or <https://www.gnu.org/licenses/>.
+ */
+
+#include "ForgeMetrics.h"
+#include "ForgeUtility.h"
+#include <cstdio>
+#include <fstream>
+
+void ForgeHookCounters::Collect(std::vector<ForgeMetricsSnapshot::Hook>& hooks) const
+{
+    for (uint32 regtype = 0; regtype <= Hooks::REGTYPE_COUNT; ++regtype)
+        for (uint32 event = 0; event < MAX_EVENTS; ++event)
+            if (calls[regtype][event])
+                hooks.push_back({ regtype, event, calls[regtype][event], time[regtype][event] });
+}
+
+ForgeMetricsMgr* ForgeMetricsMgr::instance()
+{
+    static ForgeMetricsMgr instance;
+    return &instance;
+}
+
+void ForgeMetricsMgr::Publish(ForgeMetricsSnapshot const& snapshot)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    snapshots[std::make_pair(snapshot.mapId, snapshot.instanceId)] = snapshot;
+}
+
+void ForgeMetricsMgr::Remove(int32 mapId, uint32 instanceId)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    snapshots.erase(std::make_pair(mapId, instanceId));
+}
+
+struct MetricFamily
+{
+    const char* name;
+    const char* type;
+    const char* help;
+    double (*value)(ForgeMetricsSnapshot const& snapshot);
+};
+
+// One sample per state
+static const MetricFamily stateMetrics[] =
+{
+    { "forge_userdata_pushes_total", "counter", "Objects pushed to Lua as userdata", [](ForgeMetricsSnapshot const& s) { return double(s.userdataPushes); } },
+    { "forge_userdata_reuses_total", "counter", "Userdata pushes served from the object cache", [](ForgeMetricsSnapshot const& s) { return double(s.userdataReuses); } },
+    { "forge_lua_memory_bytes", "gauge", "Memory in use by the Lua state", [](ForgeMetricsSnapshot const& s) { return double(s.memory); } },
+    { "forge_lua_gc_cycles_total", "counter", "Completed garbage collection cycles", [](ForgeMetricsSnapshot const& s) { return double(s.gcCycles); } },
+    { "forge_registry_refs", "gauge", "Live references in the Lua registry", [](ForgeMetricsSnapshot const& s) { return double(s.registryRefs); } },
+    { "forge_pending_timers", "gauge", "Scheduled timed events", [](ForgeMetricsSnapshot const& s) { return double(s.timers); } },
+    { "forge_pending_queries", "gauge", "Asynchronous queries waiting for their callback", [](ForgeMetricsSnapshot const& s) { return double(s.pendingQueries); } },
+    { "forge_waiting_coroutines", "gauge", "Coroutines suspended by NextTick or Await", [](ForgeMetricsSnapshot const& s) { return double(s.waitingCoroutines); } },
+    { "forge_deferred_jobs", "gauge", "Functions queued by Defer", [](ForgeMetricsSnapshot const& s) { return double(s.deferredJobs); } },
+    { "forge_reloads_total", "counter", "Reloads of the Lua state", [](ForgeMetricsSnapshot const& s) { return double(s.reloads); } },
+    { "forge_script_run_seconds", "gauge", "Time the scripts took to run when the state was last loaded", [](ForgeMetricsSnapshot const& s) { return s.runTime / 1000.0; } },
+};
+
+static void WriteHeader(std::ofstream& file, const char* name, const char* type, const char* help)
+{
+    file << "# HELP " << name << ' ' << help << '\n';
+    file << "# TYPE " << name << ' ' << type << '\n';
+}
+
+bool ForgeMetricsMgr::Write(std::string const& path, uint32 cacheLoadTime)
+{
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        if (!file)
+            return false;
+        // counters are written as doubles, keep them exact
+        file.precision(15);
+
+        std::lock_guard<std::mutex> guard(lock);
+
+        for (MetricFamily const& family : stateMetrics)
+        {
+            WriteHeader(file, family.name, family.type, family.help);
+            for (auto it = snapshots.begin(); it != snapshots.end(); ++it)
+                file << family.name << "{map=\"" << it->first.first << "\",instance=\"" << it->first.second << "\"} " << family.value(it->second) << '\n';
+        }
+
+        // One sample per state and hook event, calls outside of hooks have the regtype after the last register type
+        WriteHeader(file, "forge_hook_calls_total", "counter", "Calls into Lua by hook event");
+        for (auto it = snapshots.begin(); it != snapshots.end(); ++it)
+            for (ForgeMetricsSnapshot::Hook const& hook : it->second.hooks)
+                file << "forge_hook_calls_total{map=\"" << it->first.first << "\",instance=\"" << it->first.second << "\",regtype=\"" << hook.regtype << "\",event=\"" << hook.event << "\"} " << hook.calls << '\n';
+
+        WriteHeader(file, "forge_hook_seconds_total", "counter", "Time spent in Lua by hook event");
+        for (auto it = snapshots.begin(); it != snapshots.end(); ++it)
+            for (ForgeMetricsSnapshot::Hook const& hook : it->second.hooks)
+                file << "forge_hook_seconds_total{map=\"" << it->first.first << "\",instance=\"" << it->first.second << "\",regtype=\"" << hook.regtype << "\",event=\"" << hook.event << "\"} " << hook.time / 1000000.0 << '\n';
+
+        WriteHeader(file, "forge_script_cache_load_seconds", "gauge", "Time the last load of the script cache took");
+        file << "forge_script_cache_load_seconds " << cacheLoadTime / 1000.0 << '\n';
+
+        if (!file)
+            return false;
+    }
+
+#if defined FORGE_WINDOWS
+    // rename does not replace an existing file on Windows
+    std::remove(path.c_str());
+#endif
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Part of Forge <https://github.com/iThorgrim/Forge>, a standalone fork of Eluna Lua Engine.
+ *
+ * Copyright (C) Forge contributors
+ * Based on Eluna <https://elunaluaengine.github.io/>
+ * Copyright (C) Eluna Lua Engine contributors
+ *
+ * Licensed under the GNU GPL v3 only.
+ * See LICENSE file or <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FORGE_METRICS_H
+#define _FORGE_METRICS_H
+
+#include "Define.h"
+#include "Hooks.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * The metrics of a Lua state at one point in time, built by `Forge::GetMetrics` on the thread of the state.
+ */
+struct ForgeMetricsSnapshot
+{
+    struct Hook
+    {
+        uint32 regtype;
+        uint32 event;
+        uint64 calls;
+        uint64 time;            // microseconds
+    };
+
+    int32 mapId;
+    uint32 instanceId;
+    // Only counted when Forge.Metrics is enabled, events that were never called are left out
+    std::vector<Hook> hooks;
+    uint64 userdataPushes;
+    uint64 userdataReuses;      // pushes that reused the userdata of the object cache
+    uint64 memory;              // bytes
+    uint64 gcCycles;
+    uint32 registryRefs;
+    uint32 timers;
+    uint32 pendingQueries;
+    uint32 waitingCoroutines;   // suspended by NextTick or Await, sleeping coroutines are timers
+    uint32 deferredJobs;
+    uint32 reloads;
+    uint32 runTime;             // milliseconds the scripts took to run when the state was last loaded
+};
+
+/*
+ * Counts the calls into Lua of a state and the time they took by register type and event.
+ *
+ * `Forge::ExecuteCall` records every call with the hook context kept by the profiler, calls made
+ *   outside of hooks, like timed events, are counted under `Hooks::REGTYPE_COUNT`.
+ */
+class ForgeHookCounters
+{
+public:
+    // Every hook event enum fits in BindingMask::MAX_EVENTS
+    static constexpr uint32 MAX_EVENTS = 64;
+
+    ForgeHookCounters() : calls(), time() { }
+
+    void Record(uint32 regtype, uint32 event, uint64 elapsed)
+    {
+        if (regtype > Hooks::REGTYPE_COUNT || event >= MAX_EVENTS)
+            return;
+        ++calls[regtype][event];
+        time[regtype][event] += elapsed;
+    }
+
+    void Collect(std::vector<ForgeMetricsSnapshot::Hook>& hooks) const;
+
+private:
+    uint64 calls[Hooks::REGTYPE_COUNT + 1][MAX_EVENTS];
+    uint64 time[Hooks::REGTYPE_COUNT + 1][MAX_EVENTS];
+};
+
+/*
+ * Keeps the last snapshot published by each Lua state and writes them to the file of Forge.MetricsFile
+ *   in the Prometheus text format, for example for the textfile collector of the node exporter.
+ *
+ * The states publish from their own threads every Forge.MetricsIntervalMs, the world state writes the file.
+ */
+class ForgeMetricsMgr
+{
+private:
+    ForgeMetricsMgr() { }
+    ~ForgeMetricsMgr() { }
+    ForgeMetricsMgr(ForgeMetricsMgr const&) = delete;
+    ForgeMetricsMgr& operator=(ForgeMetricsMgr const&) = delete;
+
+public:
+    static ForgeMetricsMgr* instance();
+
+    void Publish(ForgeMetricsSnapshot const& snapshot);
+    // Called when a state is destroyed so its metrics are not written anymore
+    void Remove(int32 mapId, uint32 instanceId);
+    // Writes all published snapshots and the last script cache load time in milliseconds to `path`,
+    // through a temporary file so the file is never read half written. Returns false if it could not be written.
+    bool Write(std::string const& path, uint32 cacheLoadTime);
+
+private:
+    std::mutex lock;
+    std::map<std::pair<int32, uint32>, ForgeMetricsSnapshot> snapshots;
+};
+
+#define sForgeMetricsMgr ForgeMetricsMgr::instance()
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * Part of Forge <https://github.com/iThorgrim/Forge>, a standalone fork of Eluna Lua Engine.
+ *
+ * Copyright (C) Forge contributors
+ * Based on Eluna <https://elunaluaengine.github.io/>
+ * Copyright (C) Eluna Lua Engine contributors
+ *
+ * Licensed under the GNU GPL v3 only.
+ * See LICENSE file or <https://www.gnu.org/licenses/>.
+ */
+
+#include "ForgeProfiler.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+ForgeProfiler::ForgeProfiler() : enabled(false), trackContext(false), generation(0), context{ Hooks::REGTYPE_COUNT, 0, 0 }
+{
+}
+
+void ForgeProfiler::Start()
+{
+    stats.clear();
+    ++generation;
+    enabled = true;
+}
+
+void ForgeProfiler::Stop()
+{
+    enabled = false;
+    context = { Hooks::REGTYPE_COUNT, 0, 0 };
+}
+
+ForgeProfiler::Sample ForgeProfiler::Start(lua_State* L, int index)
+{
+    std::pair<Context, const void*> key(context, lua_topointer(L, index));
+    std::pair<StatsMap::iterator, bool> it = stats.emplace(key, Stats());
+    if (it.second)
+    {
+        Stats& entry = it.first->second;
+        entry.context = context;
+
+        // Resolve the source once per handler
+        lua_Debug ar;
+        lua_pushvalue(L, index);
+        if (lua_getinfo(L, ">S", &ar))
+            entry.source = std::string(ar.short_src) + ":" + std::to_string(ar.linedefined);
+        else
+            entry.source = "?";
+    }
+
+    return Sample{ &it.first->second, generation, context, std::chrono::steady_clock::now() };
+}
+
+void ForgeProfiler::Record(Sample const& sample)
+{
+    // Hooks called by the handler changed the context
+    context = sample.context;
+
+    // Cleared while the call was running
+    if (!enabled || sample.generation != generation)
+        return;
+
+    uint64 elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sample.start).count();
+
+    Stats& entry = *sample.stats;
+    ++entry.calls;
+    entry.total += elapsed;
+    entry.max = std::max(entry.max, elapsed);
+
+    uint32 bucket = 0;
+    while (bucket + 1 < HISTOGRAM_BUCKETS && elapsed >= (uint64(1) << bucket))
+        ++bucket;
+    ++entry.histogram[bucket];
+}
+
+std::vector<ForgeProfiler::Stats const*> ForgeProfiler::GetStats() const
+{
+    std::vector<Stats const*> sorted;
+    sorted.reserve(stats.size());
+    for (StatsMap::const_iterator it = stats.begin(); it != stats.end(); ++it)
+        sorted.push_back(&it->second);
+
+    std::sort(sorted.begin(), sorted.end(), [](Stats const* a, Stats const* b) { return a->total > b->total; });
+    return sorted;
+}
+
+bool ForgeProfiler::Dump(std::string const& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+        return false;
+
+    file << "# total_us calls avg_us max_us regtype event entry source histogram(<1us,<2us,<4us,...)\n";
+    for (Stats const* entry : GetStats())
+    {
+        file << entry->total << ' ' << entry->calls << ' ' << (entry->calls ? entry->total / entry->calls : 0) << ' ' << entry->max << ' '
+            << entry->context.regtype << ' ' << entry->context.event << ' ' << entry->context.entry << ' ' << entry->source << ' ';
+        for (uint32 bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket)
+            file << (bucket ? "," : "") << entry->histogram[bucket];
+        file << '\n';
+    }
+    return true;
+}
+
+std::size_t ForgeProfiler::ContextHash::operator()(std::pair<Context, const void*> const& key) const
+{
+    uint64 context = (uint64(key.first.regtype) << 48) ^ (uint64(key.first.event) << 32) ^ key.first.entry;
+    std::size_t hash = std::hash<const void*>()(key.second);
+    return hash ^ (std::hash<uint64>()(context) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+bool ForgeProfiler::ContextEqual::operator()(std::pair<Context, const void*> const& a, std::pair<Context, const void*> const& b) const
+{
+    return a.second == b.second && a.first.regtype == b.first.regtype && a.first.event == b.first.event && a.first.entry == b.first.entry;
+}
+
+ForgeSampler::ForgeSampler() : enabled(false), interval(0)
+{
+}
+
+void ForgeSampler::Start(uint32 intervalUs)
+{
+    stacks.clear();
+    interval = intervalUs;
+    lastSample = std::chrono::steady_clock::now();
+    enabled = true;
+}
+
+void ForgeSampler::Stop()
+{
+    enabled = false;
+}
+
+// Semicolons separate the frames of a folded stack
+static void AppendFrame(std::string& stack, const char* text)
+{
+    for (; *text; ++text)
+        stack += *text == ';' ? ':' : *text;
+}
+
+void ForgeSampler::Sample(lua_State* L, const char* type, const char* method)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    uint64 elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - lastSample).count();
+    if (elapsed < interval)
+        return;
+    lastSample = now;
+
+    lua_Debug ar;
+    int depth = 0;
+    while (depth < MAX_DEPTH && lua_getstack(L, depth, &ar))
+        ++depth;
+
+    // The thunk of the method is the innermost frame, it is replaced by the name of the method
+    int innermost = method ? 1 : 0;
+
+    std::string stack;
+    for (int level = depth - 1; level >= innermost; --level)
+    {
+        lua_getstack(L, level, &ar);
+        lua_getinfo(L, "Sn", &ar);
+
+        if (!stack.empty())
+            stack += ';';
+        AppendFrame(stack, ar.name ? ar.name : "?");
+        if (strcmp(ar.what, "C") != 0)
+        {
+            stack += '@';
+            AppendFrame(stack, ar.short_src);
+            stack += ':' + std::to_string(ar.linedefined);
+        }
+    }
+
+    if (method)
+    {
+        if (!stack.empty())
+            stack += ';';
+        if (type)
+        {
+            AppendFrame(stack, type);
+            stack += ':';
+        }
+        AppendFrame(stack, method);
+    }
+
+    if (!stack.empty())
+        stacks[stack] += elapsed;
+}
+
+bool ForgeSampler::Dump(std::string const& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+        return false;
+
+    for (std::unordered_map<std::string, uint64>::const_iterator it = stacks.begin(); it != stacks.end(); ++it)
+        file << it->first << ' ' << it->second << '\n';
+    return true;
+}
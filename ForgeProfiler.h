@@ -0,0 +1,201 @@
+/*
+ * Part of Forge <https://github.com/iThorgrim/Forge>, a standalone fork of Eluna Lua Engine.
+ *
+ * Copyright (C) Forge contributors
+ * Based on Eluna <https://elunaluaengine.github.io/>
+ * Copyright (C) Eluna Lua Engine contributors
+ *
+ * Licensed under the GNU GPL v3 only.
+ * See LICENSE file or <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FORGE_PROFILER_H
+#define _FORGE_PROFILER_H
+
+#include "Define.h"
+#include "Hooks.h"
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C"
+{
+#include "lua.h"
+};
+
+enum ForgeProfileRequest
+{
+    PROFILE_REQUEST_NONE,
+    PROFILE_REQUEST_START,
+    PROFILE_REQUEST_STOP,
+    PROFILE_REQUEST_DUMP,
+    PROFILE_REQUEST_SAMPLE_START,
+    PROFILE_REQUEST_SAMPLE_STOP,
+    PROFILE_REQUEST_SAMPLE_DUMP,
+    PROFILE_REQUEST_STATS
+};
+
+/*
+ * Accumulates the time spent in each Lua handler of a state, per hook and handler function.
+ *
+ * The hook helpers set the hook that is being called with `SetContext`, `Forge::ExecuteCall`
+ *   times every call with `Begin` and `End`. Calls made outside of hooks, like timed events,
+ *   are attributed to `Hooks::REGTYPE_COUNT`. When the profiler is not running only a flag is checked.
+ */
+class ForgeProfiler
+{
+public:
+    // Latency buckets, bucket N counts calls that took less than 2^N microseconds, the last one all longer calls
+    static constexpr uint32 HISTOGRAM_BUCKETS = 20;
+
+    struct Context
+    {
+        uint32 regtype;
+        uint32 event;
+        uint32 entry;
+    };
+
+    struct Stats
+    {
+        Context context;
+        std::string source; // `file:line` of the handler function
+        uint64 calls;
+        uint64 total;       // microseconds
+        uint64 max;         // microseconds
+        uint64 histogram[HISTOGRAM_BUCKETS];
+    };
+
+    struct Sample
+    {
+        Stats* stats;
+        uint32 generation;
+        Context context;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    ForgeProfiler();
+
+    bool IsEnabled() const { return enabled; }
+    // Starting clears the data of the previous run, stopping keeps it for Dump and GetStats
+    void Start();
+    void Stop();
+
+    // Keeps the hook context up to date while the profiler is stopped, for the hook counters of Forge.Metrics
+    void TrackContext(bool track) { trackContext = track; }
+    Context const& GetContext() const { return context; }
+
+    void SetContext(uint32 regtype, uint32 event, uint32 entry)
+    {
+        if (enabled || trackContext)
+            context = { regtype, event, entry };
+    }
+
+    // Calls made after this are not attributed to a hook
+    void ResetContext()
+    {
+        if (enabled || trackContext)
+            context = { Hooks::REGTYPE_COUNT, 0, 0 };
+    }
+
+    // Starts timing a call of the function at `index` of the stack
+    Sample Begin(lua_State* L, int index)
+    {
+        if (!enabled)
+            return Sample{ NULL, 0, context, std::chrono::steady_clock::time_point() };
+        return Start(L, index);
+    }
+
+    // Records the call and restores the context changed by hooks called from within it
+    void End(Sample const& sample)
+    {
+        if (sample.stats)
+            Record(sample);
+        else
+            context = sample.context;
+    }
+
+    // Returns the stats sorted by total time, longest first
+    std::vector<Stats const*> GetStats() const;
+    // Writes the stats sorted by total time to `path`, returns false if the file could not be opened
+    bool Dump(std::string const& path) const;
+
+private:
+    struct ContextHash
+    {
+        std::size_t operator()(std::pair<Context, const void*> const& key) const;
+    };
+
+    struct ContextEqual
+    {
+        bool operator()(std::pair<Context, const void*> const& a, std::pair<Context, const void*> const& b) const;
+    };
+
+    typedef std::unordered_map<std::pair<Context, const void*>, Stats, ContextHash, ContextEqual> StatsMap;
+
+    Sample Start(lua_State* L, int index);
+    void Record(Sample const& sample);
+
+    bool enabled;
+    bool trackContext;
+    // Changes whenever the stats are cleared, so calls that were running then are not recorded
+    uint32 generation;
+    Context context;
+    StatsMap stats;
+};
+
+/*
+ * Samples the Lua stacks of a state to show where the time inside of handlers goes.
+ *
+ * The count hook of the state calls `SampleLua` and the method thunks call `SampleMethod` when a bound
+ *   method returns. Once `interval` has passed since the last sample the running stack is recorded, weighted
+ *   by the microseconds since the last sample, so native methods get the time spent in them as well.
+ *   The stacks are written in the folded format of Brendan Gregg's flamegraph tools.
+ */
+class ForgeSampler
+{
+public:
+    // Deeper stacks keep their innermost frames
+    static constexpr int MAX_DEPTH = 64;
+
+    ForgeSampler();
+
+    bool IsEnabled() const { return enabled; }
+    // Starting clears the stacks of the previous run, stopping keeps them for Dump
+    void Start(uint32 intervalUs);
+    void Stop();
+
+    // Called when Lua is entered, time outside of Lua is not sampled
+    void Resume()
+    {
+        if (enabled)
+            lastSample = std::chrono::steady_clock::now();
+    }
+
+    void SampleLua(lua_State* L)
+    {
+        if (enabled)
+            Sample(L, NULL, NULL);
+    }
+
+    // `type` is NULL for global functions
+    void SampleMethod(lua_State* L, const char* type, const char* method)
+    {
+        if (enabled)
+            Sample(L, type, method);
+    }
+
+    // Writes the folded stacks to `path`, returns false if the file could not be opened
+    bool Dump(std::string const& path) const;
+
+private:
+    void Sample(lua_State* L, const char* type, const char* method);
+
+    bool enabled;
+    uint64 interval; // microseconds
+    std::chrono::steady_clock::time_point lastSample;
+    // Folded stack -> microseconds
+    std::unordered_map<std::string, uint64> stacks;
+};
+
+#endif
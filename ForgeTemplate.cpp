@@ -38,10 +38,10 @@ template<> inline int ForgeTemplate<long long>::LessOrEqual(lua_State* L) { retu
 template<> inline int ForgeTemplate<long long>::ToString(lua_State* L) { return ForgeTemplateHelper<long long>::ToString(L); }
 template<> inline int ForgeTemplate<long long>::Pow(lua_State* L) { return ForgeTemplateHelper<long long>::Pow(L); }
 
-template<> inline int ForgeTemplate<ObjectGuid>::Equal(lua_State* L) { Forge* F = Forge::GetForge(L); F->Push(F->CHECKVAL<ObjectGuid>(1) == F->CHECKVAL<ObjectGuid>(2)); return 1; }
+template<> inline int ForgeTemplate<ObjectGuid>::Equal(lua_State* L) { Forge* F = Forge::GetForge(L, 1); F->Push(F->CHECKVAL<ObjectGuid>(1) == F->CHECKVAL<ObjectGuid>(2)); return 1; }
 template<> inline int ForgeTemplate<ObjectGuid>::ToString(lua_State* L)
 {
-    Forge* F = Forge::GetForge(L);
+    Forge* F = Forge::GetForge(L, 1);
     F->Push(F->CHECKVAL<ObjectGuid>(1).ToString());
     return 1;
 }
@@ -23,10 +23,102 @@ extern "C"
 #include "ForgeCompat.h"
 #include "SharedDefines.h"
 
+class Aura;
+class Object;
+class WorldObject;
+
+// Identifiers of the types exposed to Lua, used to check userdata types without comparing names
+enum ForgeTypeId : uint8
+{
+    FORGE_TYPE_NONE,
+    FORGE_TYPE_OBJECT,
+    FORGE_TYPE_WORLDOBJECT,
+    FORGE_TYPE_UNIT,
+    FORGE_TYPE_PLAYER,
+    FORGE_TYPE_CREATURE,
+    FORGE_TYPE_GAMEOBJECT,
+    FORGE_TYPE_CORPSE,
+    FORGE_TYPE_ITEM,
+    FORGE_TYPE_VEHICLE,
+    FORGE_TYPE_GROUP,
+    FORGE_TYPE_GUILD,
+    FORGE_TYPE_AURA,
+    FORGE_TYPE_SPELL,
+    FORGE_TYPE_QUEST,
+    FORGE_TYPE_MAP,
+    FORGE_TYPE_BATTLEGROUND,
+    FORGE_TYPE_WORLDPACKET,
+    FORGE_TYPE_QUERY,
+    FORGE_TYPE_ITEMTEMPLATE,
+    FORGE_TYPE_LONG_LONG,
+    FORGE_TYPE_ULONG_LONG,
+    FORGE_TYPE_OBJECTGUID,
+    FORGE_TYPE_COUNT
+};
+
+static_assert(FORGE_TYPE_COUNT <= FORGE_MAX_TYPES, "ForgeTypeId does not fit in a 32 bit type mask");
+
+#define FORGE_TYPE_BIT(type) (uint32(1) << (type))
+
+/*
+ * Describes the type ID of `T` and the mask of `T` and all of its base types.
+ *   An object satisfies a check for type `B` if the bit of `B` is set in its mask.
+ */
+template<typename T>
+struct ForgeTypeInfo
+{
+    static constexpr ForgeTypeId id = FORGE_TYPE_NONE;
+    static constexpr uint32 mask = 0;
+};
+
+#define FORGE_TYPE_INFO(type, typeId, baseMask) \
+template<> \
+struct ForgeTypeInfo<type> \
+{ \
+    static constexpr ForgeTypeId id = typeId; \
+    static constexpr uint32 mask = FORGE_TYPE_BIT(typeId) | (baseMask); \
+}
+
+FORGE_TYPE_INFO(Object, FORGE_TYPE_OBJECT, 0);
+FORGE_TYPE_INFO(WorldObject, FORGE_TYPE_WORLDOBJECT, ForgeTypeInfo<Object>::mask);
+FORGE_TYPE_INFO(Unit, FORGE_TYPE_UNIT, ForgeTypeInfo<WorldObject>::mask);
+FORGE_TYPE_INFO(Player, FORGE_TYPE_PLAYER, ForgeTypeInfo<Unit>::mask);
+FORGE_TYPE_INFO(Creature, FORGE_TYPE_CREATURE, ForgeTypeInfo<Unit>::mask);
+FORGE_TYPE_INFO(GameObject, FORGE_TYPE_GAMEOBJECT, ForgeTypeInfo<WorldObject>::mask);
+FORGE_TYPE_INFO(Corpse, FORGE_TYPE_CORPSE, ForgeTypeInfo<WorldObject>::mask);
+FORGE_TYPE_INFO(Item, FORGE_TYPE_ITEM, ForgeTypeInfo<Object>::mask);
+FORGE_TYPE_INFO(Vehicle, FORGE_TYPE_VEHICLE, 0);
+FORGE_TYPE_INFO(Group, FORGE_TYPE_GROUP, 0);
+FORGE_TYPE_INFO(Guild, FORGE_TYPE_GUILD, 0);
+FORGE_TYPE_INFO(Aura, FORGE_TYPE_AURA, 0);
+FORGE_TYPE_INFO(Spell, FORGE_TYPE_SPELL, 0);
+FORGE_TYPE_INFO(Quest, FORGE_TYPE_QUEST, 0);
+FORGE_TYPE_INFO(Map, FORGE_TYPE_MAP, 0);
+FORGE_TYPE_INFO(BattleGround, FORGE_TYPE_BATTLEGROUND, 0);
+FORGE_TYPE_INFO(WorldPacket, FORGE_TYPE_WORLDPACKET, 0);
+FORGE_TYPE_INFO(ForgeQuery, FORGE_TYPE_QUERY, 0);
+FORGE_TYPE_INFO(ItemTemplate, FORGE_TYPE_ITEMTEMPLATE, 0);
+FORGE_TYPE_INFO(long long, FORGE_TYPE_LONG_LONG, 0);
+FORGE_TYPE_INFO(unsigned long long, FORGE_TYPE_ULONG_LONG, 0);
+FORGE_TYPE_INFO(ObjectGuid, FORGE_TYPE_OBJECTGUID, 0);
+
+/*
+ * Converts the wrapped pointer of an object with type ID `type` to `T*`.
+ *   Base types are specialized in LuaEngine.cpp to adjust the pointer from the concrete type.
+ */
+template<typename T>
+inline T* ForgeObjectCast(ForgeTypeId /*type*/, void* obj)
+{
+    return static_cast<T*>(obj);
+}
+template<> Object* ForgeObjectCast<Object>(ForgeTypeId type, void* obj);
+template<> WorldObject* ForgeObjectCast<WorldObject>(ForgeTypeId type, void* obj);
+template<> Unit* ForgeObjectCast<Unit>(ForgeTypeId type, void* obj);
+
 class ForgeObject
 {
 public:
-    ForgeObject(Forge* F, char const* tname) : F(F), type_name(tname)
+    ForgeObject(Forge* F, char const* tname, ForgeTypeId typeId, uint32 typeMask) : F(F), type_name(tname), type_mask(typeMask), type_id(typeId)
     {
     }
 
@@ -38,19 +130,25 @@ public:
     virtual void* GetObjIfValid() const = 0;
     // Returns pointer to the wrapped object's type name
     const char* GetTypeName() const { return type_name; }
+    // Returns the type ID of the wrapped object
+    ForgeTypeId GetTypeId() const { return type_id; }
+    // Returns true if the wrapped object is of the given type or derives from it
+    bool IsType(ForgeTypeId type) const { return (type_mask & FORGE_TYPE_BIT(type)) != 0; }
     // Invalidates the pointer if it should be invalidated
     virtual void Invalidate() = 0;
 
 protected:
     Forge* F;
     const char* type_name;
+    uint32 type_mask;
+    ForgeTypeId type_id;
 };
 
 template <typename T>
 class ForgeObjectImpl : public ForgeObject
 {
 public:
-    ForgeObjectImpl(Forge* F, T* obj, char const* tname) : ForgeObject(F, tname), _obj(obj), callstackid(F->GetCallstackId())
+    ForgeObjectImpl(Forge* F, T* obj, char const* tname) : ForgeObject(F, tname, ForgeTypeInfo<T>::id, ForgeTypeInfo<T>::mask), _obj(obj), callstackid(F->GetCallstackId())
     {
     }
 
@@ -73,7 +171,7 @@ template <typename T>
 class ForgeObjectValueImpl : public ForgeObject
 {
 public:
-    ForgeObjectValueImpl(Forge* F, T const* obj, char const* tname) : ForgeObject(F, tname), _obj(*obj /*always a copy, what gets passed here might be pointing to something not owned by us*/)
+    ForgeObjectValueImpl(Forge* F, T const* obj, char const* tname) : ForgeObject(F, tname, ForgeTypeInfo<T>::id, ForgeTypeInfo<T>::mask), _obj(*obj /*always a copy, what gets passed here might be pointing to something not owned by us*/)
     {
     }
 
@@ -149,16 +247,27 @@ public:
         luaL_newmetatable(L, tname);
         int metatable = lua_gettop(L);
 
+        // keep a ref to the metatable so Push can fetch it by type ID instead of by name
+        if constexpr (ForgeTypeInfo<T>::id != FORGE_TYPE_NONE)
+        {
+            lua_pushvalue(L, metatable);
+            F->SetMetatableRef(ForgeTypeInfo<T>::id, luaL_ref(L, LUA_REGISTRYINDEX));
+        }
+
         // push methodtable to stack to be accessed and modified by users
         lua_pushvalue(L, metatable);
         lua_setglobal(L, tname);
 
+        // metamethods carry the owning state as upvalue 1 so they never look it up from the registry
+
         // tostring
-        lua_pushcfunction(L, ToString);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, ToString, 1);
         lua_setfield(L, metatable, "__tostring");
 
         // garbage collecting
-        lua_pushcfunction(L, CollectGarbage);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, CollectGarbage, 1);
         lua_setfield(L, metatable, "__gc");
 
         // TODO: Safe to remove this?
@@ -167,55 +276,68 @@ public:
         lua_setfield(L, metatable, "__index");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Add);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Add, 1);
         lua_setfield(L, metatable, "__add");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Subtract);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Subtract, 1);
         lua_setfield(L, metatable, "__sub");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Multiply);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Multiply, 1);
         lua_setfield(L, metatable, "__mul");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Divide);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Divide, 1);
         lua_setfield(L, metatable, "__div");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Mod);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Mod, 1);
         lua_setfield(L, metatable, "__mod");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Pow);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Pow, 1);
         lua_setfield(L, metatable, "__pow");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, UnaryMinus);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, UnaryMinus, 1);
         lua_setfield(L, metatable, "__unm");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Concat);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Concat, 1);
         lua_setfield(L, metatable, "__concat");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Length);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Length, 1);
         lua_setfield(L, metatable, "__len");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Equal);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Equal, 1);
         lua_setfield(L, metatable, "__eq");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Less);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Less, 1);
         lua_setfield(L, metatable, "__lt");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, LessOrEqual);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, LessOrEqual, 1);
         lua_setfield(L, metatable, "__le");
 
         // make new indexes saved to methods
-        lua_pushcfunction(L, Call);
+        lua_pushlightuserdata(L, F);
+        lua_pushcclosure(L, Call, 1);
         lua_setfield(L, metatable, "__call");
 
         // special method to get the object type
@@ -285,9 +407,10 @@ public:
                 }
             }
 
-            // push a closure to the thunk with the method pointer as light user data
+            // push a closure to the thunk with the method pointer and the owning state as light user data
             lua_pushlightuserdata(L, (void*)method);
-            lua_pushcclosure(L, thunk, 1);
+            lua_pushlightuserdata(L, F);
+            lua_pushcclosure(L, thunk, 2);
             lua_rawset(L, -3);
         }
 
@@ -305,27 +428,65 @@ public:
 
         typedef ForgeObjectImpl<T> ForgeObjectType;
 
+        // value types are copied on every push, only object pointers can share a userdata
+        constexpr bool isValue = std::is_base_of_v<ForgeObjectValueImpl<T>, ForgeObjectType>;
+
+        int cacheRef = isValue ? LUA_NOREF : F->GetObjectCacheRef();
+        if (cacheRef != LUA_NOREF)
+        {
+            // Reuse the userdata pushed for this object earlier in the same call stack
+            lua_rawgeti(L, LUA_REGISTRYINDEX, cacheRef);
+            lua_pushlightuserdata(L, const_cast<T*>(obj));
+            lua_rawget(L, -2);
+            ForgeObject* cached = static_cast<ForgeObject*>(lua_touserdata(L, -1));
+            if (cached && cached->GetTypeId() == ForgeTypeInfo<T>::id && cached->GetObjIfValid() == obj)
+            {
+                lua_remove(L, -2);
+                F->CountUserdataPush(true);
+                return 1;
+            }
+            lua_pop(L, 1);
+            // Stack: cache
+        }
+
         // Create new userdata
         ForgeObjectType* forgeObject = static_cast<ForgeObjectType*>(lua_newuserdata(L, sizeof(ForgeObjectType)));
         if (!forgeObject)
         {
             FORGE_LOG_ERROR("%s could not create new userdata", tname);
+            if (cacheRef != LUA_NOREF)
+                lua_pop(L, 1);
             lua_pushnil(L);
             return 1;
         }
         new (forgeObject) ForgeObjectType(F, const_cast<T*>(obj), tname);
+        F->CountUserdataPush(false);
 
         // Set metatable for it
-        lua_pushstring(L, tname);
-        lua_rawget(L, LUA_REGISTRYINDEX);
+        if constexpr (ForgeTypeInfo<T>::id != FORGE_TYPE_NONE)
+            lua_rawgeti(L, LUA_REGISTRYINDEX, F->GetMetatableRef(ForgeTypeInfo<T>::id));
+        else
+        {
+            lua_pushstring(L, tname);
+            lua_rawget(L, LUA_REGISTRYINDEX);
+        }
         if (!lua_istable(L, -1))
         {
             FORGE_LOG_ERROR("%s missing metatable", tname);
-            lua_pop(L, 2);
+            lua_pop(L, cacheRef != LUA_NOREF ? 3 : 2);
             lua_pushnil(L);
             return 1;
         }
         lua_setmetatable(L, -2);
+
+        if (cacheRef != LUA_NOREF)
+        {
+            // Stack: cache, userdata
+            lua_pushlightuserdata(L, const_cast<T*>(obj));
+            lua_pushvalue(L, -2);
+            lua_rawset(L, -4);
+            lua_remove(L, -2);
+        }
         return 1;
     }
 
@@ -333,7 +494,7 @@ public:
     {
         lua_State* L = F->L;
 
-        ForgeObject* forgeObj = F->CHECKTYPE(narg, tname, error);
+        ForgeObject* forgeObj = F->CHECKTYPE(narg, ForgeTypeInfo<T>::id, tname, error);
         if (!forgeObj)
             return NULL;
 
@@ -352,7 +513,7 @@ public:
             }
             return NULL;
         }
-        return static_cast<T*>(obj);
+        return ForgeObjectCast<T>(forgeObj->GetTypeId(), obj);
     }
 
     static int GetType(lua_State* L)
@@ -364,7 +525,7 @@ public:
     static int thunk(lua_State* L)
     {
         ForgeRegister<T>* l = static_cast<ForgeRegister<T>*>(lua_touserdata(L, lua_upvalueindex(1)));
-        Forge* F = Forge::GetForge(L);
+        Forge* F = Forge::GetForge(L, 2);
 
         // determine if the method table functions are global or non-global
         constexpr bool isGlobal = std::is_same_v<T, void>;
@@ -393,6 +554,12 @@ public:
             ASSERT(false);
         }
         lua_settop(L, top + expected);
+
+        // the time since the last sample was spent in this method
+        if constexpr (isGlobal)
+            F->GetSampler().SampleMethod(L, NULL, l->name);
+        else
+            F->GetSampler().SampleMethod(L, tname, l->name);
         return expected;
     }
 
@@ -401,7 +568,7 @@ public:
     // Remember special cases like ForgeTemplate<Vehicle>::CollectGarbage
     static int CollectGarbage(lua_State* L)
     {
-        Forge* F = Forge::GetForge(L);
+        Forge* F = Forge::GetForge(L, 1);
 
         // Get object pointer (and check type, no error)
         ForgeObject* obj = F->CHECKOBJ<ForgeObject>(1, false);
@@ -411,7 +578,7 @@ public:
 
     static int ToString(lua_State* L)
     {
-        Forge* F = Forge::GetForge(L);
+        Forge* F = Forge::GetForge(L, 1);
 
         T* obj = F->CHECKOBJ<T>(1, true); // get self
         lua_pushfstring(L, "%s: %p", tname, obj);
@@ -429,7 +596,7 @@ public:
     static int UnaryMinus(lua_State* L) { return ArithmeticError(L); }
     static int Concat(lua_State* L) { return luaL_error(L, "attempt to concatenate a %s value", tname); }
     static int Length(lua_State* L) { return luaL_error(L, "attempt to get length of a %s value", tname); }
-    static int Equal(lua_State* L) { Forge* F = Forge::GetForge(L); F->Push(F->CHECKOBJ<T>(1) == F->CHECKOBJ<T>(2)); return 1; }
+    static int Equal(lua_State* L) { Forge* F = Forge::GetForge(L, 1); F->Push(F->CHECKOBJ<T>(1) == F->CHECKOBJ<T>(2)); return 1; }
     static int Less(lua_State* L) { return CompareError(L); }
     static int LessOrEqual(lua_State* L) { return CompareError(L); }
     static int Call(lua_State* L) { return luaL_error(L, "attempt to call a %s value", tname); }
@@ -446,7 +613,7 @@ class ForgeTemplateHelper
 public:
     static int PerformOp(lua_State* L, std::function<T(T, T)> op)
     {
-        Forge* F = Forge::GetForge(L);
+        Forge* F = Forge::GetForge(L, 1);
         T val1 = F->CHECKVAL<T>(1);
         T val2 = F->CHECKVAL<T>(2);
         F->Push(op(val1, val2));
@@ -455,7 +622,7 @@ public:
 
     static int PerformOp(lua_State* L, std::function<T(T)> op)
     {
-        Forge* F = Forge::GetForge(L);
+        Forge* F = Forge::GetForge(L, 1);
 
         T val = F->CHECKVAL<T>(1);
         F->Push(op(val));
@@ -464,7 +631,7 @@ public:
 
     static int ToString(lua_State* L)
     {
-        Forge* F = Forge::GetForge(L);
+        Forge* F = Forge::GetForge(L, 1);
 
         T val = F->CHECKVAL<T>(1);
         std::ostringstream ss;
@@ -475,7 +642,7 @@ public:
 
     static int Pow(lua_State* L)
     {
-        Forge* F = Forge::GetForge(L);
+        Forge* F = Forge::GetForge(L, 1);
 
         T val1 = F->CHECKVAL<T>(1);
         T val2 = F->CHECKVAL<T>(2);
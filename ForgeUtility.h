@@ -35,6 +35,10 @@
 #define FORGE_WINDOWS
 #endif
 
+#if defined TRINITY_DEBUG
+#define FORGE_DEBUG
+#endif
+
 typedef QueryResult ForgeQuery;
 #define GET_GUID                GetGUID
 #define HIGHGUID_PLAYER         HighGuid::Player
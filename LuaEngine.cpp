@@ -49,6 +49,8 @@ void Forge::_ReloadForge()
     RunScripts();
 
     reload = false;
+    reloadChanged = false;
+    ++reloads;
 }
 
 Forge::Forge(Map* map, bool compatMode) :
@@ -56,10 +58,34 @@ event_level(0),
 push_counter(0),
 boundMap(map),
 compatibilityMode(compatMode),
+objectCacheRef(LUA_NOREF),
+runningCoroutine(NULL),
+coroutineEventLevel(0),
+tickBudget(0),
+tickUsage(0),
+lastTickUsage(0),
+watchdogInstructions(0),
+watchdogTime(0),
+callInstructions(0),
+timeCalls(false),
+budgetExceeded(false),
+budgetYield(false),
+runningJob(NULL),
+hasProfileRequests(false),
+userdataPushes(0),
+userdataReuses(0),
+gcCycles(0),
+pendingQueries(0),
+reloads(0),
+runTime(0),
+metricsTimer(0),
+fileReloads(sForgeLoader->GetFileReloadCount()),
 
 L(NULL),
 eventMgr(NULL),
 
+BoundHooks(NULL),
+
 ServerEventBindings(NULL),
 PlayerEventBindings(NULL),
 GuildEventBindings(NULL),
@@ -81,6 +107,8 @@ InstanceEventBindings(NULL),
 
 CreatureUniqueBindings(NULL)
 {
+    std::fill(std::begin(metatableRefs), std::end(metatableRefs), LUA_NOREF);
+
     OpenLua();
     eventMgr = new EventMgr(this);
 
@@ -93,6 +121,8 @@ CreatureUniqueBindings(NULL)
 
 Forge::~Forge()
 {
+    sForgeMetricsMgr->Remove(GetBoundMapId(), GetBoundInstanceId());
+
     CloseLua();
     delete eventMgr;
     eventMgr = NULL;
@@ -102,12 +132,26 @@ void Forge::CloseLua()
 {
     OnLuaStateClose();
 
+#if defined FORGE_DEBUG
+    if (BoundHooks)
+        FORGE_LOG_DEBUG("[Forge]: Hook fast path taken for %llu of %llu hook calls", BoundHooks->GetFastPathHits(), BoundHooks->GetHookCalls());
+#endif
+
     DestroyBindStores();
 
     // Must close lua state after deleting stores and mgr
     if (L)
         lua_close(L);
     L = NULL;
+    objectCacheRef = LUA_NOREF;
+    std::fill(std::begin(metatableRefs), std::end(metatableRefs), LUA_NOREF);
+
+    // suspended coroutines died with the state
+    nextTickCoroutines.clear();
+    awaitingCoroutines.clear();
+    deferredJobs.clear();
+    scriptCache.reset();
+    loadedModules.clear();
 
     instanceDataRefs.clear();
     continentDataRefs.clear();
@@ -119,20 +163,28 @@ static int PrecompiledLoader(lua_State* L)
     if (modname == NULL)
         return 0;
 
-    const std::vector<LuaScript>& scripts = sForgeLoader->GetLuaScripts();
-
-    auto it = std::find_if(scripts.begin(), scripts.end(), [modname](const LuaScript& script) { return script.filename == modname; });
-    if (it == scripts.end()) {
+    // the cache is NULL if the state was opened before the scripts were loaded
+    Forge* F = Forge::GetForge(L);
+    const LuaScript* script = NULL;
+    if (const LuaScriptCache* cache = F->GetScriptCache())
+    {
+        auto it = cache->index.find(modname);
+        if (it != cache->index.end())
+            script = it->second;
+    }
+    if (!script) {
         lua_pushfstring(L, "\n\tno precompiled script '%s' found", modname);
         return 1;
     }
-    if (luaL_loadbuffer(L, reinterpret_cast<const char*>(&it->bytecode[0]), it->bytecode.size(), it->filename.c_str()))
+    if (luaL_loadbuffer(L, reinterpret_cast<const char*>(&script->bytecode[0]), script->bytecode.size(), script->filename.c_str()))
     {
         // Stack: modname, errmsg
         return lua_error(L);
     }
+    // a change to the script reloads the state, see ScriptsChanged
+    F->AddLoadedModule(modname);
     // Stack: modname, filefunction
-    lua_pushstring(L, it->filepath.c_str());
+    lua_pushstring(L, script->filepath.c_str());
     // Stack: modname, filefunction, modpath
     return 2;
 }
@@ -140,9 +192,14 @@ static int PrecompiledLoader(lua_State* L)
 void Forge::OpenLua()
 {
     L = luaL_newstate();
+    scriptCache = sForgeLoader->GetScriptCache();
 
     lua_pushlightuserdata(L, this);
     lua_setfield(L, LUA_REGISTRYINDEX, FORGE_STATE_PTR);
+#if LUA_VERSION_NUM >= 503
+    static_assert(LUA_EXTRASPACE >= sizeof(Forge*), "LUA_EXTRASPACE must be able to hold the Forge state pointer");
+    *static_cast<Forge**>(lua_getextraspace(L)) = this;
+#endif
 
     CreateBindStores();
 
@@ -152,6 +209,44 @@ void Forge::OpenLua()
     // Register methods and functions
     RegisterMethods(this);
 
+    // Check the tick budget and the watchdog every FORGE_HOOK_COUNT instructions, coroutines inherit the hook
+    tickBudget = uint64(sForgeConfig->GetConfig(CONFIG_FORGE_TICK_BUDGET)) * 1000;
+    watchdogInstructions = sForgeConfig->GetConfig(CONFIG_FORGE_WATCHDOG_INSTRUCTIONS);
+    watchdogTime = uint64(sForgeConfig->GetConfig(CONFIG_FORGE_WATCHDOG_MS)) * 1000;
+    timeCalls = tickBudget || watchdogTime;
+    UpdateCountHook();
+
+    // Count the calls of each hook, the profiler keeps track of the hook being called
+    if (!sForgeConfig->GetConfig(CONFIG_FORGE_METRICS))
+        hookCounters.reset();
+    else if (!hookCounters)
+        hookCounters.reset(new ForgeHookCounters());
+    profiler.TrackContext(hookCounters != nullptr);
+
+    CreateGCSentinel(L);
+
+    // Register the functions that suspend the running coroutine, see RunCoroutine
+    lua_pushlightuserdata(L, this);
+    lua_pushcclosure(L, &CoroutineSleep, 1);
+    lua_setglobal(L, "Sleep");
+    lua_pushlightuserdata(L, this);
+    lua_pushcclosure(L, &CoroutineNextTick, 1);
+    lua_setglobal(L, "NextTick");
+    lua_pushlightuserdata(L, this);
+    lua_pushcclosure(L, &CoroutineAwait, 1);
+    lua_setglobal(L, "Await");
+
+    // create the userdata reuse cache, values are weak so cached userdata can still be collected
+    if (sForgeConfig->GetConfig(CONFIG_FORGE_OBJECT_CACHE))
+    {
+        lua_newtable(L);
+        lua_newtable(L);
+        lua_pushstring(L, "v");
+        lua_setfield(L, -2, "__mode");
+        lua_setmetatable(L, -2);
+        objectCacheRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
     // get require paths
     const std::string& requirepath = sForgeLoader->GetRequirePath();
     const std::string& requirecpath = sForgeLoader->GetRequireCPath();
@@ -184,26 +279,28 @@ void Forge::CreateBindStores()
 {
     DestroyBindStores();
 
-    ServerEventBindings      = new BindingMap< EventKey<Hooks::ServerEvents> >(L);
-    PlayerEventBindings      = new BindingMap< EventKey<Hooks::PlayerEvents> >(L);
-    GuildEventBindings       = new BindingMap< EventKey<Hooks::GuildEvents> >(L);
-    GroupEventBindings       = new BindingMap< EventKey<Hooks::GroupEvents> >(L);
-    VehicleEventBindings     = new BindingMap< EventKey<Hooks::VehicleEvents> >(L);
-    BGEventBindings          = new BindingMap< EventKey<Hooks::BGEvents> >(L);
+    BoundHooks               = new BindingMask();
 
-    PacketEventBindings      = new BindingMap< EntryKey<Hooks::PacketEvents> >(L);
-    CreatureEventBindings    = new BindingMap< EntryKey<Hooks::CreatureEvents> >(L);
-    CreatureGossipBindings   = new BindingMap< EntryKey<Hooks::GossipEvents> >(L);
-    GameObjectEventBindings  = new BindingMap< EntryKey<Hooks::GameObjectEvents> >(L);
-    GameObjectGossipBindings = new BindingMap< EntryKey<Hooks::GossipEvents> >(L);
-    SpellEventBindings       = new BindingMap< EntryKey<Hooks::SpellEvents> >(L);
-    ItemEventBindings        = new BindingMap< EntryKey<Hooks::ItemEvents> >(L);
-    ItemGossipBindings       = new BindingMap< EntryKey<Hooks::GossipEvents> >(L);
-    PlayerGossipBindings     = new BindingMap< EntryKey<Hooks::GossipEvents> >(L);
-    MapEventBindings         = new BindingMap< EntryKey<Hooks::InstanceEvents> >(L);
-    InstanceEventBindings    = new BindingMap< EntryKey<Hooks::InstanceEvents> >(L);
+    ServerEventBindings      = new BindingMap< EventKey<Hooks::ServerEvents> >(L, BoundHooks, Hooks::REGTYPE_SERVER);
+    PlayerEventBindings      = new BindingMap< EventKey<Hooks::PlayerEvents> >(L, BoundHooks, Hooks::REGTYPE_PLAYER);
+    GuildEventBindings       = new BindingMap< EventKey<Hooks::GuildEvents> >(L, BoundHooks, Hooks::REGTYPE_GUILD);
+    GroupEventBindings       = new BindingMap< EventKey<Hooks::GroupEvents> >(L, BoundHooks, Hooks::REGTYPE_GROUP);
+    VehicleEventBindings     = new BindingMap< EventKey<Hooks::VehicleEvents> >(L, BoundHooks, Hooks::REGTYPE_VEHICLE);
+    BGEventBindings          = new BindingMap< EventKey<Hooks::BGEvents> >(L, BoundHooks, Hooks::REGTYPE_BG);
 
-    CreatureUniqueBindings   = new BindingMap< UniqueObjectKey<Hooks::CreatureEvents> >(L);
+    PacketEventBindings      = new BindingMap< EntryKey<Hooks::PacketEvents> >(L, BoundHooks, Hooks::REGTYPE_PACKET);
+    CreatureEventBindings    = new BindingMap< EntryKey<Hooks::CreatureEvents> >(L, BoundHooks, Hooks::REGTYPE_CREATURE);
+    CreatureGossipBindings   = new BindingMap< EntryKey<Hooks::GossipEvents> >(L, BoundHooks, Hooks::REGTYPE_CREATURE_GOSSIP);
+    GameObjectEventBindings  = new BindingMap< EntryKey<Hooks::GameObjectEvents> >(L, BoundHooks, Hooks::REGTYPE_GAMEOBJECT);
+    GameObjectGossipBindings = new BindingMap< EntryKey<Hooks::GossipEvents> >(L, BoundHooks, Hooks::REGTYPE_GAMEOBJECT_GOSSIP);
+    SpellEventBindings       = new BindingMap< EntryKey<Hooks::SpellEvents> >(L, BoundHooks, Hooks::REGTYPE_SPELL);
+    ItemEventBindings        = new BindingMap< EntryKey<Hooks::ItemEvents> >(L, BoundHooks, Hooks::REGTYPE_ITEM);
+    ItemGossipBindings       = new BindingMap< EntryKey<Hooks::GossipEvents> >(L, BoundHooks, Hooks::REGTYPE_ITEM_GOSSIP);
+    PlayerGossipBindings     = new BindingMap< EntryKey<Hooks::GossipEvents> >(L, BoundHooks, Hooks::REGTYPE_PLAYER_GOSSIP);
+    MapEventBindings         = new BindingMap< EntryKey<Hooks::InstanceEvents> >(L, BoundHooks, Hooks::REGTYPE_MAP);
+    InstanceEventBindings    = new BindingMap< EntryKey<Hooks::InstanceEvents> >(L, BoundHooks, Hooks::REGTYPE_INSTANCE);
+
+    CreatureUniqueBindings   = new BindingMap< UniqueObjectKey<Hooks::CreatureEvents> >(L, BoundHooks, Hooks::REGTYPE_CREATURE);
 }
 
 void Forge::DestroyBindStores()
@@ -229,6 +326,8 @@ void Forge::DestroyBindStores()
 
     delete CreatureUniqueBindings;
 
+    delete BoundHooks;
+
     ServerEventBindings = NULL;
     PlayerEventBindings = NULL;
     GuildEventBindings = NULL;
@@ -249,6 +348,8 @@ void Forge::DestroyBindStores()
     InstanceEventBindings = NULL;
 
     CreatureUniqueBindings = NULL;
+
+    BoundHooks = NULL;
 }
 
 void Forge::RunScripts()
@@ -260,23 +361,15 @@ void Forge::RunScripts()
     uint32 oldMSTime = ForgeUtil::GetCurrTime();
     uint32 count = 0;
 
-    std::unordered_map<std::string, std::string> loaded; // filename, path
-
     lua_getglobal(L, "require");
     // Stack: require
 
-    const std::vector<LuaScript>& scripts = sForgeLoader->GetLuaScripts();
+    // Duplicate names were already left out when the cache was built
+    static const std::vector<LuaScript> noScripts;
+    const std::vector<LuaScript>& scripts = scriptCache ? scriptCache->scripts : noScripts;
 
     for (auto it = scripts.begin(); it != scripts.end(); ++it)
     {
-        // Check that no duplicate names exist
-        if (loaded.find(it->filename) != loaded.end())
-        {
-            FORGE_LOG_ERROR("[Forge]: Error loading `%s`. File with same name already loaded from `%s`, rename either file", it->filepath.c_str(), loaded[it->filename].c_str());
-            continue;
-        }
-        loaded[it->filename] = it->filepath;
-
         // We call require on the filename to load the script
         // A custom loader is used to load the script from the combined_scripts table
         // The loader is set up in Forge::OpenLua
@@ -293,7 +386,8 @@ void Forge::RunScripts()
     }
     // Stack: require
     lua_pop(L, 1);
-    FORGE_LOG_INFO("[Forge]: Executed %u Lua scripts in %u ms for map: %i, instance: %u", count, ForgeUtil::GetTimeDiff(oldMSTime), boundMapId, boundInstanceId);
+    runTime = ForgeUtil::GetTimeDiff(oldMSTime);
+    FORGE_LOG_INFO("[Forge]: Executed %u Lua scripts in %u ms for map: %i, instance: %u", count, runTime, boundMapId, boundInstanceId);
 
     OnLuaStateOpen();
 }
@@ -356,6 +450,11 @@ bool Forge::ExecuteCall(int params, int res)
         ASSERT(false); // stack probably corrupt
     }
 
+    ForgeProfiler::Sample sample = profiler.Begin(L, base);
+    std::chrono::steady_clock::time_point start;
+    if (hookCounters)
+        start = std::chrono::steady_clock::now();
+
     bool usetrace = sForgeConfig->GetConfig(CONFIG_FORGE_TRACEBACK);
     if (usetrace)
     {
@@ -366,9 +465,16 @@ bool Forge::ExecuteCall(int params, int res)
     }
 
     // Objects are invalidated when event_level hits 0
+    if (!event_level)
+        StartCallClock();
     ++event_level;
     int result = lua_pcall(L, params, res, usetrace ? base : 0);
     --event_level;
+    if (!event_level)
+        StopCallClock();
+    if (hookCounters)
+        hookCounters->Record(sample.context.regtype, sample.context.event, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    profiler.End(sample);
 
     if (usetrace)
     {
@@ -398,19 +504,346 @@ bool Forge::ExecuteCall(int params, int res)
     return true;
 }
 
+void Forge::RunCoroutine(int nargs)
+{
+    // Stack: function, [arguments]
+    lua_State* co = lua_newthread(L);
+    // Stack: function, [arguments], thread
+    lua_insert(L, -(nargs + 2));
+    // Stack: thread, function, [arguments]
+    lua_xmove(L, co, nargs + 1);
+    // Stack: thread
+
+    // the thread stays on the stack while it runs, once suspended it is referenced by what resumes it
+    ResumeCoroutine(co, nargs);
+    lua_pop(L, 1);
+}
+
+void Forge::ResumeCoroutine(lua_State* co, int nargs)
+{
+    lua_State* prevL = L;
+    lua_State* prevCoroutine = runningCoroutine;
+    uint32 prevEventLevel = coroutineEventLevel;
+    int prevTop = lua_gettop(prevL);
+
+    // Methods called by the coroutine use the stack of the coroutine
+    L = co;
+    runningCoroutine = co;
+
+    // Objects are invalidated when event_level hits 0, so objects pushed before suspending must be fetched again after resuming
+    if (!event_level)
+        StartCallClock();
+    ++event_level;
+    coroutineEventLevel = event_level;
+#if LUA_VERSION_NUM >= 504
+    int nresults;
+    int result = lua_resume(co, prevL, nargs, &nresults);
+#elif LUA_VERSION_NUM >= 502
+    int result = lua_resume(co, prevL, nargs);
+#else
+    int result = lua_resume(co, nargs);
+#endif
+    --event_level;
+    if (!event_level)
+        StopCallClock();
+
+    L = prevL;
+    runningCoroutine = prevCoroutine;
+    coroutineEventLevel = prevEventLevel;
+
+    // Hooks called by the coroutine use its stack, nothing may be left on the stack that resumed it
+    ASSERT(lua_gettop(L) == prevTop);
+
+    if (result == LUA_YIELD)
+    {
+        // Suspended by Sleep, NextTick or Await which already arranged the resume, drop the yielded values.
+        // A job suspended by the tick budget yielded from the count hook, its stack holds the live registers of the interrupted function
+        if (!budgetYield)
+        {
+#if LUA_VERSION_NUM >= 504
+            lua_pop(co, nresults);
+#else
+            lua_pop(co, lua_gettop(co));
+#endif
+        }
+    }
+    else
+    {
+        if (result)
+        {
+            // Stack of co: errmsg
+#if LUA_VERSION_NUM >= 502 || defined LUAJIT_VERSION
+            if (sForgeConfig->GetConfig(CONFIG_FORGE_TRACEBACK))
+            {
+                luaL_traceback(co, co, lua_tostring(co, -1), 0);
+                lua_remove(co, -2);
+            }
+#endif
+            Report(co);
+        }
+
+        // The coroutine is dead, a query it did not await can no longer resume it
+        awaitingCoroutines.erase(co);
+        lua_settop(co, 0);
+    }
+
+    if (event_level == 0)
+        InvalidateObjects();
+}
+
+void Forge::ResumeCoroutines()
+{
+    if (nextTickCoroutines.empty())
+        return;
+
+    // Coroutines suspended by NextTick while these run are resumed on the next update
+    resumingCoroutines.swap(nextTickCoroutines);
+    for (int threadRef : resumingCoroutines)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, threadRef);
+        luaL_unref(L, LUA_REGISTRYINDEX, threadRef);
+        // Stack: thread
+        ResumeCoroutine(lua_tothread(L, -1), 0);
+        lua_pop(L, 1);
+    }
+    resumingCoroutines.clear();
+}
+
+void Forge::Defer(int nargs)
+{
+    // Stack: function, [arguments]
+    lua_State* co = lua_newthread(L);
+    // Stack: function, [arguments], thread
+    lua_insert(L, -(nargs + 2));
+    // Stack: thread, function, [arguments]
+    lua_xmove(L, co, nargs + 1);
+    // Stack: thread
+    deferredJobs.push_back(luaL_ref(L, LUA_REGISTRYINDEX));
+}
+
+void Forge::RunDeferredJobs()
+{
+    // Jobs deferred by the jobs that run now wait for the next tick
+    size_t count = deferredJobs.size();
+    while (count-- && (!tickBudget || tickUsage < tickBudget))
+    {
+        int threadRef = deferredJobs.front();
+        deferredJobs.pop_front();
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, threadRef);
+        // Stack: thread
+        lua_State* co = lua_tothread(L, -1);
+
+        // A job that did not start yet has its function and arguments on its stack
+        runningJob = co;
+        ResumeCoroutine(co, lua_status(co) == LUA_YIELD ? 0 : lua_gettop(co) - 1);
+        runningJob = NULL;
+
+        // Out of budget, the job continues first on the next tick
+        if (budgetYield)
+        {
+            budgetYield = false;
+            deferredJobs.push_front(threadRef);
+        }
+        else
+            luaL_unref(L, LUA_REGISTRYINDEX, threadRef);
+        lua_pop(L, 1);
+    }
+}
+
+void Forge::StartCallClock()
+{
+    callInstructions = 0;
+    if (timeCalls)
+        callStart = std::chrono::steady_clock::now();
+    sampler.Resume();
+}
+
+void Forge::StopCallClock()
+{
+    if (tickBudget)
+        tickUsage += GetCallTime();
+}
+
+uint64 Forge::GetCallTime() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - callStart).count();
+}
+
+int Forge::AbortRunawayCall(lua_State* _L, uint64 elapsed)
+{
+    // Count the handler, which is the outermost Lua function of the call
+    lua_Debug frame;
+    std::string handler = "?";
+    for (int level = 0; lua_getstack(_L, level, &frame); ++level)
+    {
+        lua_getinfo(_L, "S", &frame);
+        if (strcmp(frame.what, "C") != 0)
+            handler = std::string(frame.short_src) + ":" + std::to_string(frame.linedefined);
+    }
+    ++watchdogAborts[handler];
+
+    if (timeCalls)
+        lua_pushfstring(_L, "call aborted by the watchdog after %d instructions and %d ms", int(callInstructions), int(elapsed / 1000));
+    else
+        lua_pushfstring(_L, "call aborted by the watchdog after %d instructions", int(callInstructions));
+
+#if LUA_VERSION_NUM >= 502 || defined LUAJIT_VERSION
+    // The traceback is otherwise added by the error handler
+    if (!sForgeConfig->GetConfig(CONFIG_FORGE_TRACEBACK))
+    {
+        luaL_traceback(_L, _L, lua_tostring(_L, -1), 0);
+        lua_remove(_L, -2);
+    }
+#endif
+    return lua_error(_L);
+}
+
+void Forge::CountHook(lua_State* _L, lua_Debug* ar)
+{
+    Forge* F = GetForge(_L);
+
+    // Only the calls made by ExecuteCall and ResumeCoroutine are limited and sampled
+    if (!F->event_level)
+        return;
+
+    F->sampler.SampleLua(_L);
+
+    F->callInstructions += FORGE_HOOK_COUNT;
+    uint64 elapsed = F->timeCalls ? F->GetCallTime() : 0;
+
+    if ((F->watchdogInstructions && F->callInstructions >= F->watchdogInstructions) || (F->watchdogTime && elapsed >= F->watchdogTime))
+    {
+        F->AbortRunawayCall(_L, elapsed);
+        return;
+    }
+
+    if (!F->tickBudget || F->tickUsage + elapsed < F->tickBudget)
+        return;
+
+#if LUA_VERSION_NUM >= 503
+    // Suspend the deferred job, it continues on the next tick. Hooks can only yield since Lua 5.3
+    if (_L == F->runningJob && _L == F->runningCoroutine && F->event_level == F->coroutineEventLevel && lua_isyieldable(_L))
+    {
+        F->budgetYield = true;
+        lua_yield(_L, 0);
+        return;
+    }
+#endif
+
+    // Other calls can not be suspended, report the first one over the budget of this tick
+    if (!F->budgetExceeded)
+    {
+        F->budgetExceeded = true;
+        lua_getinfo(_L, "Sl", ar);
+        FORGE_LOG_ERROR("[Forge]: Lua exceeded the tick budget of %u ms for map: %i, instance: %u at %s:%i", uint32(F->tickBudget / 1000), F->GetBoundMapId(), F->GetBoundInstanceId(), ar->short_src, ar->currentline);
+    }
+}
+
+void Forge::AwaitQuery(QueryCallback&& query)
+{
+    // the running coroutine is referenced by the callback until the query completes
+    lua_pushthread(L);
+    int threadRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    awaitingCoroutines.insert(L);
+
+    AddQueryCallback(std::move(query), [this, threadRef](QueryResult result)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, threadRef);
+        luaL_unref(L, LUA_REGISTRYINDEX, threadRef);
+        // Stack: thread
+        lua_State* co = lua_tothread(L, -1);
+
+        // Only resume a coroutine that is still waiting in Await
+        if (awaitingCoroutines.erase(co) && lua_status(co) == LUA_YIELD)
+        {
+            ForgeQuery* eq = result ? &result : nullptr;
+            Push(eq);
+            // Stack: thread, result
+            lua_xmove(L, co, 1);
+            ResumeCoroutine(co, 1);
+        }
+        lua_pop(L, 1);
+    });
+}
+
+void Forge::AddQueryCallback(QueryCallback&& query, std::function<void(QueryResult)>&& callback)
+{
+    ++pendingQueries;
+    GetQueryProcessor().AddCallback(query.WithCallback([this, callback](QueryResult result)
+    {
+        --pendingQueries;
+        callback(result);
+    }));
+}
+
+int Forge::CoroutineSleep(lua_State* _L)
+{
+    Forge* F = GetForge(_L, 1);
+    uint32 delay = static_cast<uint32>(luaL_checkinteger(_L, 1));
+    if (_L != F->L || !F->CanSuspendCoroutine())
+        return luaL_error(_L, "Sleep can only be called from a coroutine started with RunCoroutine that is not awaiting a query");
+
+    // the event ID is a ref to the coroutine, OnTimedEvent resumes it
+    lua_pushthread(_L);
+    int threadRef = luaL_ref(_L, LUA_REGISTRYINDEX);
+    F->eventMgr->globalProcessor->AddEvent(threadRef, delay, delay, 1);
+    return lua_yield(_L, 0);
+}
+
+int Forge::CoroutineNextTick(lua_State* _L)
+{
+    Forge* F = GetForge(_L, 1);
+    if (_L != F->L || !F->CanSuspendCoroutine())
+        return luaL_error(_L, "NextTick can only be called from a coroutine started with RunCoroutine that is not awaiting a query");
+
+    lua_pushthread(_L);
+    F->nextTickCoroutines.push_back(luaL_ref(_L, LUA_REGISTRYINDEX));
+    return lua_yield(_L, 0);
+}
+
+int Forge::CoroutineAwait(lua_State* _L)
+{
+    Forge* F = GetForge(_L, 1);
+
+    // nothing to wait for, e.g. the query was given a callback
+    if (!F->awaitingCoroutines.count(_L))
+        return 0;
+
+    bool nested = _L != F->runningCoroutine || F->event_level != F->coroutineEventLevel;
+#if LUA_VERSION_NUM >= 503
+    nested = nested || !lua_isyieldable(_L);
+#endif
+    if (nested)
+        return luaL_error(_L, "Await can not be called from an event handler or pcall nested in the coroutine");
+
+    // resumed by the query callback, which passes the result
+    return lua_yield(_L, 0);
+}
+
 void Forge::Push()
 {
     lua_pushnil(L);
 }
 void Forge::Push(const long long l)
 {
+#if LUA_VERSION_NUM >= 503
+    // 64 bit integers are native since Lua 5.3, no need for a userdata
+    lua_pushinteger(L, static_cast<lua_Integer>(l));
+#else
     // pushing pointer to local is fine, a copy of value will be stored, not pointer itself
     ForgeTemplate<long long>::Push(this, &l);
+#endif
 }
 void Forge::Push(const unsigned long long l)
 {
+#if LUA_VERSION_NUM >= 503
+    // values above INT64_MAX wrap around to negative integers and are converted back by CHECKVAL
+    lua_pushinteger(L, static_cast<lua_Integer>(l));
+#else
     // pushing pointer to local is fine, a copy of value will be stored, not pointer itself
     ForgeTemplate<unsigned long long>::Push(this, &l);
+#endif
 }
 void Forge::Push(const long l)
 {
@@ -527,8 +960,13 @@ void Forge::Push(Object const* obj)
 }
 void Forge::Push(ObjectGuid const guid)
 {
+#if LUA_VERSION_NUM >= 503
+    // the raw 64 bit guid is pushed as an integer, CHECKVAL<ObjectGuid> accepts it back
+    lua_pushinteger(L, static_cast<lua_Integer>(guid.GetRawValue()));
+#else
     // pushing pointer to local is fine, a copy of value will be stored, not pointer itself
     ForgeTemplate<ObjectGuid>::Push(this, &guid);
+#endif
 }
 
 static int CheckIntegerRange(lua_State* luastate, int narg, int min, int max)
@@ -637,6 +1075,10 @@ std::string Forge::CHECKVAL<std::string>(int narg)
 template<>
 long long Forge::CHECKVAL<long long>(int narg)
 {
+#if LUA_VERSION_NUM >= 503
+    if (lua_isinteger(L, narg))
+        return static_cast<long long>(lua_tointeger(L, narg));
+#endif
     if (lua_isnumber(L, narg))
         return static_cast<long long>(CHECKVAL<double>(narg));
     return *(Forge::CHECKOBJ<long long>(narg, true));
@@ -645,8 +1087,20 @@ long long Forge::CHECKVAL<long long>(int narg)
 template<>
 unsigned long long Forge::CHECKVAL<unsigned long long>(int narg)
 {
+#if LUA_VERSION_NUM >= 503
+    // negative integers are values above INT64_MAX that wrapped around when pushed
+    if (lua_isinteger(L, narg))
+        return static_cast<unsigned long long>(lua_tointeger(L, narg));
+#endif
     if (lua_isnumber(L, narg))
-        return static_cast<unsigned long long>(CHECKVAL<uint32>(narg));
+    {
+        double value = CHECKVAL<double>(narg);
+        if (value < 0)
+            return luaL_argerror(L, narg, "value must be greater than or equal to 0");
+        if (value >= 18446744073709551616.0)
+            return luaL_argerror(L, narg, "value must be less than 2^64");
+        return static_cast<unsigned long long>(value);
+    }
     return *(Forge::CHECKOBJ<unsigned long long>(narg, true));
 }
 
@@ -665,6 +1119,10 @@ unsigned long Forge::CHECKVAL<unsigned long>(int narg)
 template<>
 ObjectGuid Forge::CHECKVAL<ObjectGuid>(int narg)
 {
+#if LUA_VERSION_NUM >= 503
+    if (lua_isinteger(L, narg))
+        return ObjectGuid(static_cast<uint64>(lua_tointeger(L, narg)));
+#endif
     ObjectGuid* guid = CHECKOBJ<ObjectGuid>(narg, true);
     return guid ? *guid : ObjectGuid();
 }
@@ -675,42 +1133,51 @@ AuraRemoveMode Forge::CHECKVAL<AuraRemoveMode>(int index) {
     return static_cast<AuraRemoveMode>(value);
 }
 
-template<> Object* Forge::CHECKOBJ<Object>(int narg, bool error)
-{
-    Object* obj = CHECKOBJ<WorldObject>(narg, false);
-    if (!obj)
-        obj = CHECKOBJ<Item>(narg, false);
-    if (!obj)
-        obj = ForgeTemplate<Object>::Check(this, narg, error);
-    return obj;
-}
-template<> WorldObject* Forge::CHECKOBJ<WorldObject>(int narg, bool error)
+template<typename Base, typename Derived>
+static Base* UpcastObject(void* obj)
 {
-    WorldObject* obj = CHECKOBJ<Unit>(narg, false);
-    if (!obj)
-        obj = CHECKOBJ<GameObject>(narg, false);
-    if (!obj)
-        obj = CHECKOBJ<Corpse>(narg, false);
-    if (!obj)
-        obj = ForgeTemplate<WorldObject>::Check(this, narg, error);
-    return obj;
+    if constexpr (std::is_base_of_v<Base, Derived>)
+        return static_cast<Derived*>(obj);
+    else
+        return NULL;
 }
-template<> Unit* Forge::CHECKOBJ<Unit>(int narg, bool error)
+
+template<typename Base>
+static Base* CastToBase(ForgeTypeId type, void* obj)
 {
-    Unit* obj = CHECKOBJ<Player>(narg, false);
-    if (!obj)
-        obj = CHECKOBJ<Creature>(narg, false);
-    if (!obj)
-        obj = ForgeTemplate<Unit>::Check(this, narg, error);
-    return obj;
+    switch (type)
+    {
+        case FORGE_TYPE_OBJECT:
+            return UpcastObject<Base, Object>(obj);
+        case FORGE_TYPE_WORLDOBJECT:
+            return UpcastObject<Base, WorldObject>(obj);
+        case FORGE_TYPE_UNIT:
+            return UpcastObject<Base, Unit>(obj);
+        case FORGE_TYPE_PLAYER:
+            return UpcastObject<Base, Player>(obj);
+        case FORGE_TYPE_CREATURE:
+            return UpcastObject<Base, Creature>(obj);
+        case FORGE_TYPE_GAMEOBJECT:
+            return UpcastObject<Base, GameObject>(obj);
+        case FORGE_TYPE_CORPSE:
+            return UpcastObject<Base, Corpse>(obj);
+        case FORGE_TYPE_ITEM:
+            return UpcastObject<Base, Item>(obj);
+        default:
+            return NULL;
+    }
 }
 
+template<> Object* ForgeObjectCast<Object>(ForgeTypeId type, void* obj) { return CastToBase<Object>(type, obj); }
+template<> WorldObject* ForgeObjectCast<WorldObject>(ForgeTypeId type, void* obj) { return CastToBase<WorldObject>(type, obj); }
+template<> Unit* ForgeObjectCast<Unit>(ForgeTypeId type, void* obj) { return CastToBase<Unit>(type, obj); }
+
 template<> ForgeObject* Forge::CHECKOBJ<ForgeObject>(int narg, bool error)
 {
-    return CHECKTYPE(narg, NULL, error);
+    return CHECKTYPE(narg, FORGE_TYPE_NONE, NULL, error);
 }
 
-ForgeObject* Forge::CHECKTYPE(int narg, const char* tname, bool error)
+ForgeObject* Forge::CHECKTYPE(int narg, ForgeTypeId type, const char* tname, bool error)
 {
     if (lua_islightuserdata(L, narg))
     {
@@ -721,7 +1188,9 @@ ForgeObject* Forge::CHECKTYPE(int narg, const char* tname, bool error)
 
     ForgeObject* forgeObject = static_cast<ForgeObject*>(lua_touserdata(L, narg));
 
-    if (!forgeObject || (tname && forgeObject->GetTypeName() != tname))
+    // types without a ForgeTypeInfo specialization are checked by their name instead
+    bool mismatch = forgeObject && (type != FORGE_TYPE_NONE ? !forgeObject->IsType(type) : tname && forgeObject->GetTypeName() != tname);
+    if (!forgeObject || mismatch)
     {
         if (error)
         {
@@ -737,7 +1206,7 @@ ForgeObject* Forge::CHECKTYPE(int narg, const char* tname, bool error)
 template<typename K>
 static int cancelBinding(lua_State* L)
 {
-    Forge* F = Forge::GetForge(L);
+    Forge* F = Forge::GetForge(L, 3);
 
     uint64 bindingID = F->CHECKVAL<uint64>(lua_upvalueindex(1));
 
@@ -754,9 +1223,10 @@ static void createCancelCallback(Forge* f, uint64 bindingID, BindingMap<K>* bind
 {
     f->Push(bindingID);
     lua_pushlightuserdata(f->L, bindings);
-    // Stack: bindingID, bindings
+    lua_pushlightuserdata(f->L, f);
+    // Stack: bindingID, bindings, forge
 
-    lua_pushcclosure(f->L, &cancelBinding<K>, 2);
+    lua_pushcclosure(f->L, &cancelBinding<K>, 3);
     // Stack: cancel_callback
 }
 
@@ -1009,14 +1479,237 @@ int Forge::Register(uint8 regtype, uint32 entry, ObjectGuid guid, uint32 instanc
     return 0;
 }
 
+void Forge::UpdateCountHook()
+{
+    // Coroutines created after this inherit the hook of the main thread
+    if (timeCalls || watchdogInstructions || sampler.IsEnabled())
+        lua_sethook(L, &CountHook, LUA_MASKCOUNT, FORGE_HOOK_COUNT);
+    else
+        lua_sethook(L, NULL, 0, 0);
+}
+
+void Forge::RequestProfile(ForgeProfileRequest request)
+{
+    std::lock_guard<std::mutex> guard(profileRequestLock);
+    profileRequests.push_back(request);
+    hasProfileRequests = true;
+}
+
+void Forge::HandleProfileRequests()
+{
+    std::vector<ForgeProfileRequest> requests;
+    {
+        std::lock_guard<std::mutex> guard(profileRequestLock);
+        requests.swap(profileRequests);
+        hasProfileRequests = false;
+    }
+
+    for (ForgeProfileRequest request : requests)
+        HandleProfileRequest(request);
+}
+
+void Forge::HandleProfileRequest(ForgeProfileRequest request)
+{
+    switch (request)
+    {
+        case PROFILE_REQUEST_START:
+            profiler.Start();
+            FORGE_LOG_INFO("[Forge]: Started profiling for map: %i, instance: %u", GetBoundMapId(), GetBoundInstanceId());
+            break;
+        case PROFILE_REQUEST_STOP:
+            profiler.Stop();
+            FORGE_LOG_INFO("[Forge]: Stopped profiling for map: %i, instance: %u", GetBoundMapId(), GetBoundInstanceId());
+            break;
+        case PROFILE_REQUEST_DUMP:
+        {
+            std::string path = "forge_profile_" + std::to_string(GetBoundMapId()) + "_" + std::to_string(GetBoundInstanceId()) + ".txt";
+            if (profiler.Dump(path))
+                FORGE_LOG_INFO("[Forge]: Wrote the profile of map: %i, instance: %u to `%s`", GetBoundMapId(), GetBoundInstanceId(), path.c_str());
+            else
+                FORGE_LOG_ERROR("[Forge]: Could not write the profile of map: %i, instance: %u to `%s`", GetBoundMapId(), GetBoundInstanceId(), path.c_str());
+            break;
+        }
+        case PROFILE_REQUEST_SAMPLE_START:
+            sampler.Start(FORGE_SAMPLE_INTERVAL);
+            UpdateCountHook();
+            FORGE_LOG_INFO("[Forge]: Started sampling for map: %i, instance: %u", GetBoundMapId(), GetBoundInstanceId());
+            break;
+        case PROFILE_REQUEST_SAMPLE_STOP:
+            sampler.Stop();
+            UpdateCountHook();
+            FORGE_LOG_INFO("[Forge]: Stopped sampling for map: %i, instance: %u", GetBoundMapId(), GetBoundInstanceId());
+            break;
+        case PROFILE_REQUEST_SAMPLE_DUMP:
+        {
+            std::string path = "forge_samples_" + std::to_string(GetBoundMapId()) + "_" + std::to_string(GetBoundInstanceId()) + ".folded";
+            if (sampler.Dump(path))
+                FORGE_LOG_INFO("[Forge]: Wrote the sampled stacks of map: %i, instance: %u to `%s`", GetBoundMapId(), GetBoundInstanceId(), path.c_str());
+            else
+                FORGE_LOG_ERROR("[Forge]: Could not write the sampled stacks of map: %i, instance: %u to `%s`", GetBoundMapId(), GetBoundInstanceId(), path.c_str());
+            break;
+        }
+        case PROFILE_REQUEST_STATS:
+            LogMetrics();
+            break;
+        default:
+            break;
+    }
+}
+
 void Forge::UpdateForge(uint32 diff)
 {
+    if (hasProfileRequests)
+        HandleProfileRequests();
+
     if (reload && sForgeLoader->GetCacheState() == SCRIPT_CACHE_READY)
         if(!GetQueryProcessor().HasPendingCallbacks())
             _ReloadForge();
 
+    // After a file changed only the states that use the changed scripts are reloaded, the others keep running with the new cache
+    if (fileReloads != sForgeLoader->GetFileReloadCount())
+    {
+        fileReloads = sForgeLoader->GetFileReloadCount();
+        reloadChanged = true;
+    }
+    if (reloadChanged && !reload && sForgeLoader->GetCacheState() == SCRIPT_CACHE_READY)
+    {
+        std::shared_ptr<const LuaScriptCache> latest = sForgeLoader->GetScriptCache();
+        if (latest && latest != scriptCache && ScriptsChanged(*latest))
+        {
+            if (!GetQueryProcessor().HasPendingCallbacks())
+                _ReloadForge();
+        }
+        else
+        {
+            scriptCache = latest;
+            reloadChanged = false;
+        }
+    }
+
+    ResumeCoroutines();
     eventMgr->globalProcessor->Update(diff);
+    if (eventMgr->objectProcessor)
+        eventMgr->objectProcessor->Update(diff);
     GetQueryProcessor().ProcessReadyCallbacks();
+    RunDeferredJobs();
+
+    // The tick ends here, deferred jobs used what was left of its budget
+    lastTickUsage = tickUsage;
+    tickUsage = 0;
+    budgetExceeded = false;
+
+    PublishMetrics(diff);
+}
+
+bool Forge::ScriptsChanged(const LuaScriptCache& latest) const
+{
+    if (!scriptCache)
+        return true;
+
+    // a loaded script was changed or removed
+    for (const std::string& name : loadedModules)
+    {
+        auto current = scriptCache->index.find(name);
+        auto updated = latest.index.find(name);
+        if (current == scriptCache->index.end() || updated == latest.index.end())
+            return true;
+        if (current->second->filepath != updated->second->filepath || current->second->hash != updated->second->hash)
+            return true;
+    }
+
+    // a script was added, every state runs all scripts, including ones that failed to compile before
+    for (const LuaScript& script : latest.scripts)
+        if (!loadedModules.count(script.filename))
+            return true;
+
+    return false;
+}
+
+ForgeMetricsSnapshot Forge::GetMetrics()
+{
+    ForgeMetricsSnapshot metrics = ForgeMetricsSnapshot();
+    metrics.mapId = GetBoundMapId();
+    metrics.instanceId = GetBoundInstanceId();
+    if (hookCounters)
+        hookCounters->Collect(metrics.hooks);
+    metrics.userdataPushes = userdataPushes;
+    metrics.userdataReuses = userdataReuses;
+    metrics.memory = uint64(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+    metrics.gcCycles = gcCycles;
+
+    // Refs are the registry array entries after the predefined ones, luaL_ref keeps its free list there as numbers
+#if defined LUA_RIDX_LAST
+    int first = LUA_RIDX_LAST + 1;
+#else
+    int first = 1;
+#endif
+    int length = static_cast<int>(lua_rawlen(L, LUA_REGISTRYINDEX));
+    for (int i = first; i <= length; ++i)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, i);
+        if (!lua_isnil(L, -1) && lua_type(L, -1) != LUA_TNUMBER)
+            ++metrics.registryRefs;
+        lua_pop(L, 1);
+    }
+
+    metrics.timers = eventMgr ? uint32(eventMgr->eventIndex.size()) : 0;
+    metrics.pendingQueries = pendingQueries;
+    metrics.waitingCoroutines = uint32(nextTickCoroutines.size() + awaitingCoroutines.size());
+    metrics.deferredJobs = uint32(deferredJobs.size());
+    metrics.reloads = reloads;
+    metrics.runTime = runTime;
+    return metrics;
+}
+
+void Forge::LogMetrics()
+{
+    ForgeMetricsSnapshot metrics = GetMetrics();
+    FORGE_LOG_INFO("[Forge]: Stats for map: %i, instance: %u: %u KB of Lua memory, %llu GC cycles, %u registry refs, %u timers, %u pending queries, %u waiting coroutines, %u deferred jobs, %llu userdata pushes (%llu reused), scripts ran in %u ms after %u reloads",
+        metrics.mapId, metrics.instanceId, uint32(metrics.memory / 1024), metrics.gcCycles, metrics.registryRefs, metrics.timers, metrics.pendingQueries,
+        metrics.waitingCoroutines, metrics.deferredJobs, metrics.userdataPushes, metrics.userdataReuses, metrics.runTime, metrics.reloads);
+
+    // The hooks Lua spent the most time in, only counted with Forge.Metrics
+    std::sort(metrics.hooks.begin(), metrics.hooks.end(), [](ForgeMetricsSnapshot::Hook const& a, ForgeMetricsSnapshot::Hook const& b) { return a.time > b.time; });
+    for (size_t i = 0; i < metrics.hooks.size() && i < 10; ++i)
+        FORGE_LOG_INFO("[Forge]:     regtype %u, event %u: %llu calls in %.3f ms", metrics.hooks[i].regtype, metrics.hooks[i].event, metrics.hooks[i].calls, metrics.hooks[i].time / 1000.0);
+}
+
+void Forge::PublishMetrics(uint32 diff)
+{
+    const std::string& path = sForgeConfig->GetConfig(CONFIG_FORGE_METRICS_FILE);
+    if (path.empty())
+        return;
+
+    metricsTimer += diff;
+    if (metricsTimer < sForgeConfig->GetConfig(CONFIG_FORGE_METRICS_INTERVAL))
+        return;
+    metricsTimer = 0;
+
+    // Every state publishes its own metrics, the world state writes them all
+    sForgeMetricsMgr->Publish(GetMetrics());
+    if (!boundMap && !sForgeMetricsMgr->Write(path, sForgeLoader->GetLastLoadTime()))
+        FORGE_LOG_ERROR("[Forge]: Could not write the metrics to `%s`", path.c_str());
+}
+
+void Forge::CreateGCSentinel(lua_State* _L)
+{
+    // An unreferenced userdata that is finalized by the next collection cycle
+    lua_newuserdata(_L, 1);
+    lua_createtable(_L, 0, 1);
+    lua_pushlightuserdata(_L, this);
+    lua_pushcclosure(_L, &GCSentinel, 1);
+    lua_setfield(_L, -2, "__gc");
+    lua_setmetatable(_L, -2);
+    lua_pop(_L, 1);
+}
+
+int Forge::GCSentinel(lua_State* _L)
+{
+    // A cycle completed, the sentinel created while the state closes is freed without being finalized
+    Forge* F = GetForge(_L, 1);
+    ++F->gcCycles;
+    F->CreateGCSentinel(_L);
+    return 0;
 }
 
 /*
@@ -1029,10 +1722,36 @@ void Forge::CleanUpStack(int number_of_arguments)
     lua_pop(L, number_of_arguments + 1); // Add 1 because the caller doesn't know about `event_id`.
     // Stack: (empty)
 
+    profiler.ResetContext();
+
     if (event_level == 0)
         InvalidateObjects();
 }
 
+/*
+ * Call the only event handler that was put on the stack with `SetupStack`.
+ *
+ * Unlike `CallOneFunction`, the function is moved below the event ID and the arguments,
+ *   which are passed to it directly instead of being copied. Only the results are left
+ *   afterwards, so pop those instead of calling `CleanUpStack`.
+ */
+int Forge::CallOnlyFunction(int number_of_arguments, int number_of_results)
+{
+    ++number_of_arguments; // Caller doesn't know about `event_id`.
+    ASSERT(number_of_arguments > 0 && number_of_results >= 0);
+    // Stack: event_id, [arguments], function
+
+    int first_argument_index = lua_gettop(L) - number_of_arguments;
+    lua_insert(L, first_argument_index);
+    // Stack: function, event_id, [arguments]
+
+    ExecuteCall(number_of_arguments, number_of_results);
+    // Stack: [results]
+
+    profiler.ResetContext();
+    return first_argument_index; // Return the location of the first result (if any exist).
+}
+
 /*
  * Call a single event handler that was put on the stack with `Setup` and removes it from the stack.
  *
@@ -1065,15 +1784,20 @@ int Forge::CallOneFunction(int number_of_functions, int number_of_arguments, int
 
 CreatureAI* Forge::GetAI(Creature* creature)
 {
+    if (CreatureEventBindings->HasBindingsForEntry(creature->GetEntry()))
+        return new ForgeCreatureAI(creature);
+
+    // Unique bindings are rare, so only look them up per event if there are any.
+    if (!CreatureUniqueBindings->HasAnyBindings())
+        return NULL;
+
     for (int i = 1; i < Hooks::CREATURE_EVENT_COUNT; ++i)
     {
         Hooks::CreatureEvents event_id = (Hooks::CreatureEvents)i;
 
-        auto entryKey = EntryKey<Hooks::CreatureEvents>(event_id, creature->GetEntry());
         auto uniqueKey = UniqueObjectKey<Hooks::CreatureEvents>(event_id, creature->GET_GUID(), creature->GetInstanceId());
 
-        if (CreatureEventBindings->HasBindingsFor(entryKey) ||
-            CreatureUniqueBindings->HasBindingsFor(uniqueKey))
+        if (CreatureUniqueBindings->HasBindingsFor(uniqueKey))
             return new ForgeCreatureAI(creature);
     }
 
@@ -1082,16 +1806,9 @@ CreatureAI* Forge::GetAI(Creature* creature)
 
 InstanceData* Forge::GetInstanceData(Map* map)
 {
-    for (int i = 1; i < Hooks::INSTANCE_EVENT_COUNT; ++i)
-    {
-        Hooks::InstanceEvents event_id = (Hooks::InstanceEvents)i;
-
-        auto key = EntryKey<Hooks::InstanceEvents>(event_id, map->GetId());
-
-        if (MapEventBindings->HasBindingsFor(key) ||
-            InstanceEventBindings->HasBindingsFor(key))
-            return new ForgeInstanceAI(map);
-    }
+    if (MapEventBindings->HasBindingsForEntry(map->GetId()) ||
+        InstanceEventBindings->HasBindingsForEntry(map->GetId()))
+        return new ForgeInstanceAI(map);
 
     return NULL;
 }
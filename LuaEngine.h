@@ -13,6 +13,8 @@
 #define _LUA_ENGINE_H
 
 #include "Common.h"
+#include "ForgeMetrics.h"
+#include "ForgeProfiler.h"
 #include "ForgeUtility.h"
 #include "Hooks.h"
 
@@ -24,6 +26,10 @@
 #include "Weather.h"
 #include "World.h"
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <memory>
 
@@ -44,6 +50,7 @@ class Guild;
 class Item;
 class Pet;
 class Player;
+class QueryCallback;
 class Quest;
 class Spell;
 class SpellCastTargets;
@@ -66,8 +73,10 @@ typedef InstanceScript InstanceData;
 struct lua_State;
 class EventMgr;
 class ForgeObject;
+enum ForgeTypeId : uint8;
 template<typename T> class ForgeTemplate;
 
+class BindingMask;
 template<typename K> class BindingMap;
 template<typename T> struct EventKey;
 template<typename T> struct EntryKey;
@@ -81,6 +90,18 @@ struct LuaScript
     std::string modulepath;
     BytecodeBuffer bytecode;
     int32 mapId;
+    // Used to find the scripts that changed between two loads of the script cache
+    uint64 fileSize;
+    uint64 sourceHash;          // of the file content
+    uint64 hash;                // of the bytecode
+};
+
+// The scripts of one load of the script cache, shared by all states opened while it was the latest
+struct LuaScriptCache
+{
+    std::vector<LuaScript> scripts;
+    // Scripts by filename, used by require. Scripts with a name that was already taken are left out of the cache.
+    std::unordered_map<std::string, const LuaScript*> index;
 };
 
 enum MethodRegisterState
@@ -92,6 +113,12 @@ enum MethodRegisterState
 };
 
 #define FORGE_STATE_PTR "Forge State Ptr"
+// Upper bound of ForgeTypeId values, the type masks in ForgeTemplate.h are 32 bits
+#define FORGE_MAX_TYPES 32
+// Amount of Lua instructions between the checks of the tick budget, the watchdog and the sampler, when enabled
+#define FORGE_HOOK_COUNT 1000
+// Microseconds between the stacks sampled by `.forge sample`
+#define FORGE_SAMPLE_INTERVAL 1000
 
 #define FORGE_GAME_API TC_GAME_API
 
@@ -102,12 +129,15 @@ public:
     typedef std::recursive_mutex LockType;
 
     void ReloadForge() { reload = true; }
+    void RequestProfile(ForgeProfileRequest request);
     bool ExecuteCall(int params, int res);
 
 private:
 
     // Indicates that the lua state should be reloaded
     bool reload = false;
+    // Indicates that the lua state should be reloaded if its scripts changed, set once the file watcher reloaded the script cache
+    bool reloadChanged = false;
 
     // A counter for lua event stacks that occur (see event_level).
     // This is used to determine whether an object belongs to the current call stack or not.
@@ -127,6 +157,76 @@ private:
     // Whether or not Forge is in compatibility mode. Used in some method wrappers.
     bool compatibilityMode;
 
+    // Registry refs of the metatables of the registered types, indexed by ForgeTypeId
+    int metatableRefs[FORGE_MAX_TYPES];
+
+    // Registry ref of the weak valued table of object pointer -> userdata used to reuse
+    // userdata pushed earlier in the same call stack, or LUA_NOREF when Forge.ObjectCache is off.
+    int objectCacheRef;
+
+    // The coroutine resumed by ResumeCoroutine that is currently running, or NULL,
+    //  and the event_level it runs at. Only this coroutine can be suspended by Sleep, NextTick and Await.
+    lua_State* runningCoroutine;
+    uint32 coroutineEventLevel;
+    // Registry refs of the coroutines suspended by NextTick, resumed on the next UpdateForge
+    std::vector<int> nextTickCoroutines;
+    std::vector<int> resumingCoroutines;
+    // Coroutines waiting for the result of an asynchronous query, see AwaitQuery
+    std::unordered_set<lua_State*> awaitingCoroutines;
+
+    // Lua execution budget of a tick in microseconds from Forge.TickBudgetMs, 0 when disabled.
+    // A tick lasts until the end of UpdateForge, only the outermost calls into Lua are timed.
+    uint64 tickBudget;
+    uint64 tickUsage;
+    uint64 lastTickUsage;
+    std::chrono::steady_clock::time_point callStart;
+    // Whether the budget of this tick was exceeded by something else than a deferred job, logged once per tick
+    bool budgetExceeded;
+    // Watchdog limits of a call in instructions and microseconds from Forge.WatchdogInstructions and Forge.WatchdogMs, 0 when disabled
+    uint64 watchdogInstructions;
+    uint64 watchdogTime;
+    // Instructions run by the current call, counted in steps of FORGE_HOOK_COUNT
+    uint64 callInstructions;
+    // Whether calls are timed, for the tick budget or the watchdog
+    bool timeCalls;
+    // Calls aborted by the watchdog, by the source of the handler
+    std::unordered_map<std::string, uint32> watchdogAborts;
+    // Set by CountHook when it suspended runningJob to continue it on the next tick
+    bool budgetYield;
+    lua_State* runningJob;
+    // Registry refs of the coroutines queued by Defer
+    std::deque<int> deferredJobs;
+
+    // Per handler timings, see `.forge profile`
+    ForgeProfiler profiler;
+    // Sampled Lua stacks, see `.forge sample`
+    ForgeSampler sampler;
+    // Queued by `.forge profile`, `.forge sample` and `.forge stats` from the world thread, handled in order by the state on its next update
+    std::mutex profileRequestLock;
+    std::vector<ForgeProfileRequest> profileRequests;
+    std::atomic<bool> hasProfileRequests;
+
+    // Hook calls and time, only allocated when Forge.Metrics is enabled, see GetMetrics
+    std::unique_ptr<ForgeHookCounters> hookCounters;
+    uint64 userdataPushes;
+    uint64 userdataReuses;
+    // Completed garbage collection cycles, counted by the finalizer of a userdata that is recreated every cycle
+    uint64 gcCycles;
+    // Queries added with AddQueryCallback that did not complete yet
+    uint32 pendingQueries;
+    uint32 reloads;
+    // Milliseconds the last RunScripts took
+    uint32 runTime;
+    // Milliseconds since the metrics were published for Forge.MetricsFile
+    uint32 metricsTimer;
+    // The last ForgeLoader::GetFileReloadCount seen by the state, see reloadChanged
+    uint32 fileReloads;
+
+    // The script cache the state was opened with, kept so require finds the same scripts after the cache is reloaded
+    std::shared_ptr<const LuaScriptCache> scriptCache;
+    // Names of the scripts loaded from scriptCache by require
+    std::unordered_set<std::string> loadedModules;
+
     // Map from instance ID -> Lua table ref
     std::unordered_map<uint32, int> instanceDataRefs;
     // Map from map ID -> Lua table ref
@@ -137,15 +237,37 @@ private:
     void DestroyBindStores();
     void CreateBindStores();
     void InvalidateObjects();
+    void ResumeCoroutines();
+    void RunDeferredJobs();
+    void HandleProfileRequests();
+    void HandleProfileRequest(ForgeProfileRequest request);
+    void LogMetrics();
+    void PublishMetrics(uint32 diff);
+    void CreateGCSentinel(lua_State* _L);
+    static int GCSentinel(lua_State* _L);
+    void UpdateCountHook();
+    void StartCallClock();
+    void StopCallClock();
+    uint64 GetCallTime() const;
+    int AbortRunawayCall(lua_State* _L, uint64 elapsed);
+    static void CountHook(lua_State* _L, lua_Debug* ar);
+
+    // Coroutine functions, these are plain C closures instead of global methods as they yield
+    static int CoroutineSleep(lua_State* _L);
+    static int CoroutineNextTick(lua_State* _L);
+    static int CoroutineAwait(lua_State* _L);
 
     // Use ReloadForge() to make forge reload
     // This is called on world update to reload forge
     void _ReloadForge();
+    // Whether a script the state loaded was changed or removed in `latest`, or a script it would run was added
+    bool ScriptsChanged(const LuaScriptCache& latest) const;
 
     // Some helpers for hooks to call event handlers.
     // The bodies of the templates are in HookHelpers.h, so if you want to use them you need to #include "HookHelpers.h".
     template<typename K1, typename K2> int SetupStack(BindingMap<K1>* bindings1, BindingMap<K2>* bindings2, const K1& key1, const K2& key2, int number_of_arguments);
                                        int CallOneFunction(int number_of_functions, int number_of_arguments, int number_of_results);
+                                       int CallOnlyFunction(int number_of_arguments, int number_of_results);
                                        void CleanUpStack(int number_of_arguments);
     template<typename T>               void ReplaceArgument(T value, uint8 index);
     template<typename K1, typename K2> void CallAllFunctions(BindingMap<K1>* bindings1, BindingMap<K2>* bindings2, const K1& key1, const K2& key2);
@@ -166,6 +288,19 @@ private:
         return CallAllFunctionsBool<K, K>(bindings, NULL, key, key, default_value);
     }
 
+    // Typed hook dispatch, where the event, the arguments and the number of results are fixed at compile time.
+    // These replace HookPush + SetupStack/CallAllFunctions, e.g. `CallHook<Hooks::PLAYER_EVENT_ON_LOGIN>(pPlayer)`.
+    // The bodies are in HookHelpers.h as well.
+    template<int NRESULTS, typename K1, typename K2, typename F, typename... Args>
+    void CallHookHandlers(BindingMap<K1>* bindings1, BindingMap<K2>* bindings2, const K1& key1, const K2& key2, F&& on_results, Args const&... args);
+    template<typename T> void ReplaceHookArgument(int args, int offset, T value);
+    template<auto EVENT, int NRESULTS, typename F, typename... Args> void CallHookResults(F&& on_results, Args const&... args);
+    template<auto EVENT, typename... Args> void CallHook(Args const&... args);
+    template<auto EVENT, typename... Args> bool CallHookBool(bool default_value, Args const&... args);
+    template<auto EVENT, int NRESULTS, typename C, typename F, typename... Args> void CallCreatureHookResults(C const* creature, F&& on_results, Args const&... args);
+    template<auto EVENT, typename C, typename... Args> void CallCreatureHook(C const* creature, Args const&... args);
+    template<auto EVENT, typename C, typename... Args> bool CallCreatureHookBool(C const* creature, bool default_value, Args const&... args);
+
     // Non-static pushes, to be used in hooks.
     // They up the pushed value counter for hook helper functions.
     void HookPush()                                 { Push(); ++push_counter; }
@@ -192,6 +327,9 @@ public:
     QueryCallbackProcessor queryProcessor;
     QueryCallbackProcessor& GetQueryProcessor() { return queryProcessor; }
 
+    // Which events of each register type have bindings, checked first by every hook
+    BindingMask* BoundHooks;
+
     BindingMap< EventKey<Hooks::ServerEvents> >*     ServerEventBindings;
     BindingMap< EventKey<Hooks::PlayerEvents> >*     PlayerEventBindings;
     BindingMap< EventKey<Hooks::GuildEvents> >*      GuildEventBindings;
@@ -219,11 +357,24 @@ public:
     // Never returns nullptr
     static Forge* GetForge(lua_State* L)
     {
+#if LUA_VERSION_NUM >= 503
+        // the state pointer is stored in the extra space of the main thread by OpenLua, new threads inherit it
+        Forge* F = *static_cast<Forge**>(lua_getextraspace(L));
+#else
         lua_pushstring(L, FORGE_STATE_PTR);
         lua_rawget(L, LUA_REGISTRYINDEX);
         ASSERT(lua_islightuserdata(L, -1));
         Forge* F = static_cast<Forge*>(lua_touserdata(L, -1));
         lua_pop(L, 1);
+#endif
+        ASSERT(F);
+        return F;
+    }
+
+    // Returns the state bound as light userdata to the given upvalue of the running C closure
+    static Forge* GetForge(lua_State* L, int upvalue)
+    {
+        Forge* F = static_cast<Forge*>(lua_touserdata(L, lua_upvalueindex(upvalue)));
         ASSERT(F);
         return F;
     }
@@ -279,10 +430,56 @@ public:
 
     void RunScripts();
     bool HasLuaState() const { return L != NULL; }
+    // NULL until the script cache is loaded
+    const LuaScriptCache* GetScriptCache() const { return scriptCache.get(); }
+    void AddLoadedModule(const char* name) { loadedModules.insert(name); }
     uint64 GetCallstackId() const { return callstackid; }
+    int GetObjectCacheRef() const { return objectCacheRef; }
+    int GetMetatableRef(ForgeTypeId type) const { return metatableRefs[type]; }
+    void SetMetatableRef(ForgeTypeId type, int ref) { metatableRefs[type] = ref; }
     int Register(uint8 reg, uint32 entry, ObjectGuid guid, uint32 instanceId, uint32 event_id, int functionRef, uint32 shots);
     void UpdateForge(uint32 diff);
 
+    // Coroutines that can suspend themselves with Sleep, NextTick and Await
+    // Runs the function below the `nargs` arguments on top of the stack in a new coroutine and pops them
+    void RunCoroutine(int nargs);
+    // Resumes the suspended coroutine `co` with `nargs` values on its stack, `co` must be kept referenced by the caller
+    void ResumeCoroutine(lua_State* co, int nargs);
+    // Resumes the running coroutine with the result of `query` once it completes, see Await
+    void AwaitQuery(QueryCallback&& query);
+    // Runs the function below the `nargs` arguments on top of the stack in a new coroutine once the tick has budget left and pops them
+    void Defer(int nargs);
+    // Time spent in Lua during the last tick in microseconds, only measured when there is a tick budget
+    uint64 GetLastTickUsage() const { return lastTickUsage; }
+    uint64 GetTickBudget() const { return tickBudget; }
+    size_t GetDeferredJobCount() const { return deferredJobs.size(); }
+    const std::unordered_map<std::string, uint32>& GetWatchdogAborts() const { return watchdogAborts; }
+    ForgeProfiler const& GetProfiler() const { return profiler; }
+    ForgeSampler& GetSampler() { return sampler; }
+    // Counts an object pushed as userdata, `reused` if the userdata came from the object cache
+    void CountUserdataPush(bool reused)
+    {
+        ++userdataPushes;
+        if (reused)
+            ++userdataReuses;
+    }
+    // Adds `query` to the query processor of the state and calls `callback` with its result, counted by the metrics
+    void AddQueryCallback(QueryCallback&& query, std::function<void(QueryResult)>&& callback);
+    // Builds the metrics of the state for `.forge stats`, GetForgeMetrics and Forge.MetricsFile
+    ForgeMetricsSnapshot GetMetrics();
+    // Whether the code being run is in a coroutine started by RunCoroutine that can be suspended right now
+    bool CanSuspendCoroutine() const
+    {
+        if (!runningCoroutine || L != runningCoroutine || event_level != coroutineEventLevel || awaitingCoroutines.count(L))
+            return false;
+#if LUA_VERSION_NUM >= 503
+        // a pcall in the coroutine can not be yielded across
+        return lua_isyieldable(L) != 0;
+#else
+        return true;
+#endif
+    }
+
     // Checks
     template<typename T> T CHECKVAL(int narg);
     template<typename T> T CHECKVAL(int narg, T def)
@@ -293,7 +490,7 @@ public:
     {
         return ForgeTemplate<T>::Check(this, narg, error);
     }
-    ForgeObject* CHECKTYPE(int narg, const char* tname, bool error = true);
+    ForgeObject* CHECKTYPE(int narg, ForgeTypeId type, const char* tname, bool error = true);
 
     CreatureAI* GetAI(Creature* creature);
     InstanceData* GetInstanceData(Map* map);
@@ -540,9 +737,6 @@ public:
     /* Spell */
     void OnSpellCast(Spell* pSpell, bool skipCheck);
 };
-template<> Unit* Forge::CHECKOBJ<Unit>(int narg, bool error);
-template<> Object* Forge::CHECKOBJ<Object>(int narg, bool error);
-template<> WorldObject* Forge::CHECKOBJ<WorldObject>(int narg, bool error);
 template<> ForgeObject* Forge::CHECKOBJ<ForgeObject>(int narg, bool error);
 
 #endif
@@ -18,9 +18,9 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT) \
-    auto key = EventKey<BGEvents>(EVENT);\
-    if (!BGEventBindings->HasBindingsFor(key))\
-        return;
+    if (!BoundHooks->IsBound(REGTYPE_BG, EVENT))\
+        return;\
+    auto key = EventKey<BGEvents>(EVENT);
 
 void Forge::OnBGStart(BattleGround* bg, BattleGroundTypeId bgId, uint32 instanceId)
 {
@@ -14,116 +14,65 @@
 #include "LuaEngine.h"
 #include "BindingMap.h"
 #include "ForgeIncludes.h"
+#include "ForgeEventMgr.h"
 #include "ForgeTemplate.h"
 
 using namespace Hooks;
 
-#define START_HOOK(EVENT, CREATURE) \
-    auto entry_key = EntryKey<CreatureEvents>(EVENT, CREATURE->GetEntry());\
-    auto unique_key = UniqueObjectKey<CreatureEvents>(EVENT, CREATURE->GET_GUID(), CREATURE->GetInstanceId());\
-    if (!CreatureEventBindings->HasBindingsFor(entry_key))\
-        if (!CreatureUniqueBindings->HasBindingsFor(unique_key))\
-            return;
-
-#define START_HOOK_WITH_RETVAL(EVENT, CREATURE, RETVAL) \
-    auto entry_key = EntryKey<CreatureEvents>(EVENT, CREATURE->GetEntry());\
-    auto unique_key = UniqueObjectKey<CreatureEvents>(EVENT, CREATURE->GET_GUID(), CREATURE->GetInstanceId());\
-    if (!CreatureEventBindings->HasBindingsFor(entry_key))\
-        if (!CreatureUniqueBindings->HasBindingsFor(unique_key))\
-            return RETVAL;
-
 void Forge::OnDummyEffect(WorldObject* pCaster, uint32 spellId, SpellEffIndex effIndex, Creature* pTarget)
 {
-    START_HOOK(CREATURE_EVENT_ON_DUMMY_EFFECT, pTarget);
-    HookPush(pCaster);
-    HookPush(spellId);
-    HookPush(effIndex);
-    HookPush(pTarget);
-    CallAllFunctions(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    CallCreatureHook<CREATURE_EVENT_ON_DUMMY_EFFECT>(pTarget, pCaster, spellId, effIndex, pTarget);
 }
 
 bool Forge::OnQuestAccept(Player* pPlayer, Creature* pCreature, Quest const* pQuest)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_QUEST_ACCEPT, pCreature, false);
-    HookPush(pPlayer);
-    HookPush(pCreature);
-    HookPush(pQuest);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_QUEST_ACCEPT>(pCreature, false, pPlayer, pCreature, pQuest);
 }
 
 bool Forge::OnQuestReward(Player* pPlayer, Creature* pCreature, Quest const* pQuest, uint32 opt)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_QUEST_REWARD, pCreature, false);
-    HookPush(pPlayer);
-    HookPush(pCreature);
-    HookPush(pQuest);
-    HookPush(opt);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_QUEST_REWARD>(pCreature, false, pPlayer, pCreature, pQuest, opt);
 }
 
 void Forge::GetDialogStatus(const Player* pPlayer, const Creature* pCreature)
 {
-    START_HOOK(CREATURE_EVENT_ON_DIALOG_STATUS, pCreature);
-    HookPush(pPlayer);
-    HookPush(pCreature);
-    CallAllFunctions(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    CallCreatureHook<CREATURE_EVENT_ON_DIALOG_STATUS>(pCreature, pPlayer, pCreature);
 }
 
 void Forge::OnAddToWorld(Creature* pCreature)
 {
-    START_HOOK(CREATURE_EVENT_ON_ADD, pCreature);
-    HookPush(pCreature);
-    CallAllFunctions(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    CallCreatureHook<CREATURE_EVENT_ON_ADD>(pCreature, pCreature);
 }
 
 void Forge::OnRemoveFromWorld(Creature* pCreature)
 {
-    START_HOOK(CREATURE_EVENT_ON_REMOVE, pCreature);
-    HookPush(pCreature);
-    CallAllFunctions(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    eventMgr->RemoveObjectEvents(pCreature->GET_GUID());
+    CallCreatureHook<CREATURE_EVENT_ON_REMOVE>(pCreature, pCreature);
 }
 
 bool Forge::OnSummoned(Creature* pCreature, Unit* pSummoner)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_SUMMONED, pCreature, false);
-    HookPush(pCreature);
-    HookPush(pSummoner);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_SUMMONED>(pCreature, false, pCreature, pSummoner);
 }
 
 bool Forge::UpdateAI(Creature* me, const uint32 diff)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_AIUPDATE, me, false);
-    HookPush(me);
-    HookPush(diff);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_AIUPDATE>(me, false, me, diff);
 }
 
 //Called for reaction at enter to combat if not in combat yet (enemy can be NULL)
 //Called at creature aggro either by MoveInLOS or Attack Start
 bool Forge::EnterCombat(Creature* me, Unit* target)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_ENTER_COMBAT, me, false);
-    HookPush(me);
-    HookPush(target);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_ENTER_COMBAT>(me, false, me, target);
 }
 
 // Called at any Damage from any attacker (before damage apply)
 bool Forge::DamageTaken(Creature* me, Unit* attacker, uint32& damage)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_DAMAGE_TAKEN, me, false);
     bool result = false;
-    HookPush(me);
-    HookPush(attacker);
-    HookPush(damage);
-    int damageIndex = lua_gettop(L);
-    int n = SetupStack(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key, 3);
-
-    while (n > 0)
+    CallCreatureHookResults<CREATURE_EVENT_ON_DAMAGE_TAKEN, 2>(me, [&](int r, int args)
     {
-        int r = CallOneFunction(n--, 3, 2);
-
         if (lua_isboolean(L, r + 0) && lua_toboolean(L, r + 0))
             result = true;
 
@@ -131,13 +80,9 @@ bool Forge::DamageTaken(Creature* me, Unit* attacker, uint32& damage)
         {
             damage = CHECKVAL<uint32>(r + 1);
             // Update the stack for subsequent calls.
-            ReplaceArgument(damage, damageIndex);
+            ReplaceHookArgument(args, 2, damage);
         }
-
-        lua_pop(L, 2);
-    }
-
-    CleanUpStack(3);
+    }, me, attacker, damage);
     return result;
 }
 
@@ -145,108 +90,71 @@ bool Forge::DamageTaken(Creature* me, Unit* attacker, uint32& damage)
 bool Forge::JustDied(Creature* me, Unit* killer)
 {
     On_Reset(me);
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_DIED, me, false);
-    HookPush(me);
-    HookPush(killer);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_DIED>(me, false, me, killer);
 }
 
 //Called at creature killing another unit
 bool Forge::KilledUnit(Creature* me, Unit* victim)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_TARGET_DIED, me, false);
-    HookPush(me);
-    HookPush(victim);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_TARGET_DIED>(me, false, me, victim);
 }
 
 // Called when the creature summon successfully other creature
 bool Forge::JustSummoned(Creature* me, Creature* summon)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_JUST_SUMMONED_CREATURE, me, false);
-    HookPush(me);
-    HookPush(summon);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_JUST_SUMMONED_CREATURE>(me, false, me, summon);
 }
 
 // Called when a summoned creature is despawned
 bool Forge::SummonedCreatureDespawn(Creature* me, Creature* summon)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_SUMMONED_CREATURE_DESPAWN, me, false);
-    HookPush(me);
-    HookPush(summon);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_SUMMONED_CREATURE_DESPAWN>(me, false, me, summon);
 }
 
 //Called at waypoint reached or PointMovement end
 bool Forge::MovementInform(Creature* me, uint32 type, uint32 id)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_REACH_WP, me, false);
-    HookPush(me);
-    HookPush(type);
-    HookPush(id);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_REACH_WP>(me, false, me, type, id);
 }
 
 // Called before EnterCombat even before the creature is in combat.
 bool Forge::AttackStart(Creature* me, Unit* target)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_PRE_COMBAT, me, false);
-    HookPush(me);
-    HookPush(target);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_PRE_COMBAT>(me, false, me, target);
 }
 
 // Called for reaction at stopping attack at no attackers or targets
 bool Forge::EnterEvadeMode(Creature* me)
 {
     On_Reset(me);
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_LEAVE_COMBAT, me, false);
-    HookPush(me);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_LEAVE_COMBAT>(me, false, me);
 }
 
 // Called when creature is spawned or respawned (for reseting variables)
 bool Forge::JustRespawned(Creature* me)
 {
     On_Reset(me);
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_SPAWN, me, false);
-    HookPush(me);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_SPAWN>(me, false, me);
 }
 
 // Called at reaching home after evade
 bool Forge::JustReachedHome(Creature* me)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_REACH_HOME, me, false);
-    HookPush(me);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_REACH_HOME>(me, false, me);
 }
 
 // Called at text emote receive from player
 bool Forge::ReceiveEmote(Creature* me, Player* player, uint32 emoteId)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_RECEIVE_EMOTE, me, false);
-    HookPush(me);
-    HookPush(player);
-    HookPush(emoteId);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_RECEIVE_EMOTE>(me, false, me, player, emoteId);
 }
 
 // called when the corpse of this creature gets removed
 bool Forge::CorpseRemoved(Creature* me, uint32& respawnDelay)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_CORPSE_REMOVED, me, false);
     bool result = false;
-    HookPush(me);
-    HookPush(respawnDelay);
-    int respawnDelayIndex = lua_gettop(L);
-    int n = SetupStack(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key, 2);
-
-    while (n > 0)
+    CallCreatureHookResults<CREATURE_EVENT_ON_CORPSE_REMOVED, 2>(me, [&](int r, int args)
     {
-        int r = CallOneFunction(n--, 2, 2);
-
         if (lua_isboolean(L, r + 0) && lua_toboolean(L, r + 0))
             result = true;
 
@@ -254,79 +162,52 @@ bool Forge::CorpseRemoved(Creature* me, uint32& respawnDelay)
         {
             respawnDelay = CHECKVAL<uint32>(r + 1);
             // Update the stack for subsequent calls.
-            ReplaceArgument(respawnDelay, respawnDelayIndex);
+            ReplaceHookArgument(args, 1, respawnDelay);
         }
-
-        lua_pop(L, 2);
-    }
-
-    CleanUpStack(2);
+    }, me, respawnDelay);
     return result;
 }
 
 bool Forge::MoveInLineOfSight(Creature* me, Unit* who)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_MOVE_IN_LOS, me, false);
-    HookPush(me);
-    HookPush(who);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_MOVE_IN_LOS>(me, false, me, who);
 }
 
 // Called on creature initial spawn, respawn, death, evade (leave combat)
 void Forge::On_Reset(Creature* me) // Not an override, custom
 {
-    START_HOOK(CREATURE_EVENT_ON_RESET, me);
-    HookPush(me);
-    CallAllFunctions(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    CallCreatureHook<CREATURE_EVENT_ON_RESET>(me, me);
 }
 
 // Called when hit by a spell
 bool Forge::SpellHit(Creature* me, WorldObject* caster, SpellInfo const* spell)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_HIT_BY_SPELL, me, false);
-    HookPush(me);
-    HookPush(caster);
-    HookPush(spell->Id); // Pass spell object?
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_HIT_BY_SPELL>(me, false, me, caster, spell->Id); // Pass spell object?
 }
 
 // Called when spell hits a target
 bool Forge::SpellHitTarget(Creature* me, WorldObject* target, SpellInfo const* spell)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_SPELL_HIT_TARGET, me, false);
-    HookPush(me);
-    HookPush(target);
-    HookPush(spell->Id); // Pass spell object?
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_SPELL_HIT_TARGET>(me, false, me, target, spell->Id); // Pass spell object?
 }
 
 #if defined FORGE_TRINITY
 
 bool Forge::SummonedCreatureDies(Creature* me, Creature* summon, Unit* killer)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_SUMMONED_CREATURE_DIED, me, false);
-    HookPush(me);
-    HookPush(summon);
-    HookPush(killer);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_SUMMONED_CREATURE_DIED>(me, false, me, summon, killer);
 }
 
 // Called when owner takes damage
 bool Forge::OwnerAttackedBy(Creature* me, Unit* attacker)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_OWNER_ATTACKED_AT, me, false);
-    HookPush(me);
-    HookPush(attacker);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_OWNER_ATTACKED_AT>(me, false, me, attacker);
 }
 
 // Called when owner attacks something
 bool Forge::OwnerAttacked(Creature* me, Unit* target)
 {
-    START_HOOK_WITH_RETVAL(CREATURE_EVENT_ON_OWNER_ATTACKED, me, false);
-    HookPush(me);
-    HookPush(target);
-    return CallAllFunctionsBool(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key);
+    return CallCreatureHookBool<CREATURE_EVENT_ON_OWNER_ATTACKED>(me, false, me, target);
 }
 
 #endif // FORGE_TRINITY
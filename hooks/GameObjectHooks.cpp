@@ -20,11 +20,15 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT, ENTRY) \
+    if (!BoundHooks->IsBound(REGTYPE_GAMEOBJECT, EVENT))\
+        return;\
     auto key = EntryKey<GameObjectEvents>(EVENT, ENTRY);\
     if (!GameObjectEventBindings->HasBindingsFor(key))\
         return;
 
 #define START_HOOK_WITH_RETVAL(EVENT, ENTRY, RETVAL) \
+    if (!BoundHooks->IsBound(REGTYPE_GAMEOBJECT, EVENT))\
+        return RETVAL;\
     auto key = EntryKey<GameObjectEvents>(EVENT, ENTRY);\
     if (!GameObjectEventBindings->HasBindingsFor(key))\
         return RETVAL;
@@ -124,6 +128,7 @@ void Forge::OnAddToWorld(GameObject* pGameObject)
 
 void Forge::OnRemoveFromWorld(GameObject* pGameObject)
 {
+    eventMgr->RemoveObjectEvents(pGameObject->GET_GUID());
     START_HOOK(GAMEOBJECT_EVENT_ON_REMOVE, pGameObject->GetEntry());
     HookPush(pGameObject);
     CallAllFunctions(GameObjectEventBindings, key);
@@ -19,11 +19,15 @@
 using namespace Hooks;
 
 #define START_HOOK(BINDINGS, EVENT, ENTRY) \
+    if (!BoundHooks->IsBound(BINDINGS->GetRegisterType(), EVENT))\
+        return;\
     auto key = EntryKey<GossipEvents>(EVENT, ENTRY);\
     if (!BINDINGS->HasBindingsFor(key))\
         return;
 
 #define START_HOOK_WITH_RETVAL(BINDINGS, EVENT, ENTRY, RETVAL) \
+    if (!BoundHooks->IsBound(BINDINGS->GetRegisterType(), EVENT))\
+        return RETVAL;\
     auto key = EntryKey<GossipEvents>(EVENT, ENTRY);\
     if (!BINDINGS->HasBindingsFor(key))\
         return RETVAL;
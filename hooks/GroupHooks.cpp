@@ -18,14 +18,14 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT) \
-    auto key = EventKey<GroupEvents>(EVENT);\
-    if (!GroupEventBindings->HasBindingsFor(key))\
-        return;
+    if (!BoundHooks->IsBound(REGTYPE_GROUP, EVENT))\
+        return;\
+    auto key = EventKey<GroupEvents>(EVENT);
 
 #define START_HOOK_WITH_RETVAL(EVENT, RETVAL) \
-    auto key = EventKey<GroupEvents>(EVENT);\
-    if (!GroupEventBindings->HasBindingsFor(key))\
-        return RETVAL;
+    if (!BoundHooks->IsBound(REGTYPE_GROUP, EVENT))\
+        return RETVAL;\
+    auto key = EventKey<GroupEvents>(EVENT);
 
 void Forge::OnAddMember(Group* group, ObjectGuid guid)
 {
@@ -18,9 +18,9 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT) \
-    auto key = EventKey<GuildEvents>(EVENT);\
-    if (!GuildEventBindings->HasBindingsFor(key))\
-        return;
+    if (!BoundHooks->IsBound(REGTYPE_GUILD, EVENT))\
+        return;\
+    auto key = EventKey<GuildEvents>(EVENT);
 
 void Forge::OnAddMember(Guild* guild, Player* player, uint32 plRank)
 {
@@ -13,8 +13,16 @@
 #define _HOOK_HELPERS_H
 
 #include "LuaEngine.h"
+#include "BindingMap.h"
 #include "ForgeUtility.h"
 
+/*
+ * Entry of a binding key reported by the profiler, 0 for keys without one.
+ */
+template<typename T> uint32 GetProfileEntry(EventKey<T> const& /*key*/) { return 0; }
+template<typename T> uint32 GetProfileEntry(EntryKey<T> const& key) { return key.entry; }
+template<typename T> uint32 GetProfileEntry(UniqueObjectKey<T> const& key) { return GUID_ENPART(key.guid); }
+
 /*
  * Sets up the stack so that event handlers can be called.
  *
@@ -44,6 +52,9 @@ int Forge::SetupStack(BindingMap<K1>* bindings1, BindingMap<K2>* bindings2, cons
         bindings2->PushRefsFor(key2);
     // Stack: event_id, [arguments], [functions]
 
+    // Reset by CleanUpStack or CallOnlyFunction
+    profiler.SetContext(bindings1->GetRegisterType(), key1.event_id, GetProfileEntry(key1));
+
     int number_of_functions = lua_gettop(L) - arguments_top;
     return number_of_functions;
 }
@@ -76,6 +87,16 @@ void Forge::CallAllFunctions(BindingMap<K1>* bindings1, BindingMap<K2>* bindings
     int number_of_functions = SetupStack(bindings1, bindings2, key1, key2, number_of_arguments);
     // Stack: event_id, [arguments], [functions]
 
+    if (number_of_functions == 1)
+    {
+        CallOnlyFunction(number_of_arguments, 0);
+        // Stack: (empty)
+
+        if (event_level == 0)
+            InvalidateObjects();
+        return;
+    }
+
     while (number_of_functions > 0)
     {
         CallOneFunction(number_of_functions, number_of_arguments, 0);
@@ -104,6 +125,22 @@ bool Forge::CallAllFunctionsBool(BindingMap<K1>* bindings1, BindingMap<K2>* bind
     int number_of_functions = SetupStack(bindings1, bindings2, key1, key2, number_of_arguments);
     // Stack: event_id, [arguments], [functions]
 
+    if (number_of_functions == 1)
+    {
+        int r = CallOnlyFunction(number_of_arguments, 1);
+        // Stack: result
+
+        if (lua_isboolean(L, r) && (lua_toboolean(L, r) == 1) != default_value)
+            result = !default_value;
+
+        lua_pop(L, 1);
+        // Stack: (empty)
+
+        if (event_level == 0)
+            InvalidateObjects();
+        return result;
+    }
+
     while (number_of_functions > 0)
     {
         int r = CallOneFunction(number_of_functions, number_of_arguments, 1);
@@ -123,4 +160,192 @@ bool Forge::CallAllFunctionsBool(BindingMap<K1>* bindings1, BindingMap<K2>* bind
     return result;
 }
 
+/*
+ * Maps an event enum to the register type and binding store of its `EventKey` bindings.
+ */
+template<typename T> struct HookBindings;
+
+#define FORGE_HOOK_BINDINGS(EVENTS, REGTYPE, BINDINGS) \
+    template<> struct HookBindings<Hooks::EVENTS> \
+    { \
+        static constexpr Hooks::RegisterTypes regtype = Hooks::REGTYPE; \
+        static BindingMap< EventKey<Hooks::EVENTS> >* Get(Forge* F) { return F->BINDINGS; } \
+    }
+
+FORGE_HOOK_BINDINGS(ServerEvents, REGTYPE_SERVER, ServerEventBindings);
+FORGE_HOOK_BINDINGS(PlayerEvents, REGTYPE_PLAYER, PlayerEventBindings);
+FORGE_HOOK_BINDINGS(GuildEvents, REGTYPE_GUILD, GuildEventBindings);
+FORGE_HOOK_BINDINGS(GroupEvents, REGTYPE_GROUP, GroupEventBindings);
+FORGE_HOOK_BINDINGS(VehicleEvents, REGTYPE_VEHICLE, VehicleEventBindings);
+FORGE_HOOK_BINDINGS(BGEvents, REGTYPE_BG, BGEventBindings);
+
+#undef FORGE_HOOK_BINDINGS
+
+/*
+ * Call all event handlers bound to `key1` (and `key2`) with the event ID and `args`.
+ *
+ * The number of arguments and results is fixed at compile time, so unlike
+ *   SetupStack/CallOneFunction nothing has to be counted or inserted: the
+ *   arguments are pushed once below the functions and copied above each
+ *   function when it is called.
+ *
+ * After each handler `on_results(r, a)` is called, where `r` is the stack index
+ *   of its first result and `a` is the stack index of the first argument after
+ *   the event ID (see `ReplaceHookArgument`). The results are popped afterwards.
+ *
+ * A single handler is moved below the arguments and called with them directly,
+ *   so nothing is copied. No handler follows it, so `a` is 0 in that case.
+ */
+template<int NRESULTS, typename K1, typename K2, typename F, typename... Args>
+void Forge::CallHookHandlers(BindingMap<K1>* bindings1, BindingMap<K2>* bindings2, const K1& key1, const K2& key2, F&& on_results, Args const&... args)
+{
+    constexpr int number_of_arguments = sizeof...(Args) + 1; // Add 1 for `event_id`.
+
+    int base = lua_gettop(L);
+    Push(key1.event_id);
+    (Push(args), ...);
+    // Stack: event_id, [arguments]
+
+    bindings1->PushRefsFor(key1);
+    if (bindings2)
+        bindings2->PushRefsFor(key2);
+    // Stack: event_id, [arguments], [functions]
+
+    profiler.SetContext(bindings1->GetRegisterType(), key1.event_id, GetProfileEntry(key1));
+
+    if (lua_gettop(L) == base + number_of_arguments + 1)
+    {
+        lua_insert(L, base + 1);
+        // Stack: function, event_id, [arguments]
+
+        ExecuteCall(number_of_arguments, NRESULTS);
+        // Stack: [results]
+
+        on_results(base + 1, 0);
+        lua_settop(L, base);
+        // Stack: (empty)
+
+        profiler.ResetContext();
+
+        if (event_level == 0)
+            InvalidateObjects();
+        return;
+    }
+
+    for (int function_index = lua_gettop(L); function_index > base + number_of_arguments; --function_index)
+    {
+        for (int argument_index = base + 1; argument_index <= base + number_of_arguments; ++argument_index)
+            lua_pushvalue(L, argument_index);
+        // Stack: event_id, [arguments], [functions], event_id, [arguments]
+
+        ExecuteCall(number_of_arguments, NRESULTS);
+        // Stack: event_id, [arguments], [functions - 1], [results]
+
+        on_results(function_index, base + 2);
+        lua_pop(L, NRESULTS);
+        // Stack: event_id, [arguments], [functions - 1]
+    }
+
+    lua_settop(L, base);
+    // Stack: (empty)
+
+    profiler.ResetContext();
+    if (event_level == 0)
+        InvalidateObjects();
+}
+
+/*
+ * Replace the hook argument `offset` places after the first one, whose stack index `args`
+ *   is handed to the result callback, for the handlers called after this one.
+ *
+ * Does nothing if `args` is 0, i.e. when no handler follows.
+ */
+template<typename T>
+void Forge::ReplaceHookArgument(int args, int offset, T value)
+{
+    if (!args)
+        return;
+
+    Push(value);
+    lua_replace(L, args + offset);
+}
+
+/*
+ * Call all event handlers bound to `EVENT` with `args`, passing the results
+ *   of each one to `on_results` (see `CallHookHandlers`).
+ */
+template<auto EVENT, int NRESULTS, typename F, typename... Args>
+void Forge::CallHookResults(F&& on_results, Args const&... args)
+{
+    typedef decltype(EVENT) EventType;
+    typedef HookBindings<EventType> Bindings;
+
+    // `EventKey` bindings are tracked exactly by `BoundHooks`, no need to check the store.
+    if (!BoundHooks->IsBound(Bindings::regtype, EVENT))
+        return;
+
+    auto key = EventKey<EventType>(EVENT);
+    CallHookHandlers<NRESULTS>(Bindings::Get(this), (BindingMap< EventKey<EventType> >*)NULL, key, key, on_results, args...);
+}
+
+/*
+ * Call all event handlers bound to `EVENT` with `args` and ignore any results.
+ */
+template<auto EVENT, typename... Args>
+void Forge::CallHook(Args const&... args)
+{
+    CallHookResults<EVENT, 0>([](int, int) { }, args...);
+}
+
+/*
+ * Call all event handlers bound to `EVENT` with `args`, and returns `default_value`
+ *   if ALL event handlers returned `default_value`, otherwise returns the opposite of `default_value`.
+ */
+template<auto EVENT, typename... Args>
+bool Forge::CallHookBool(bool default_value, Args const&... args)
+{
+    bool result = default_value;
+    CallHookResults<EVENT, 1>([&](int r, int)
+    {
+        if (lua_isboolean(L, r) && (lua_toboolean(L, r) == 1) != default_value)
+            result = !default_value;
+    }, args...);
+    return result;
+}
+
+/*
+ * Same as `CallHookResults`, but for creature events bound by entry or to the unique `creature`.
+ */
+template<auto EVENT, int NRESULTS, typename C, typename F, typename... Args>
+void Forge::CallCreatureHookResults(C const* creature, F&& on_results, Args const&... args)
+{
+    if (!BoundHooks->IsBound(Hooks::REGTYPE_CREATURE, EVENT))
+        return;
+
+    auto entry_key = EntryKey<Hooks::CreatureEvents>(EVENT, creature->GetEntry());
+    auto unique_key = UniqueObjectKey<Hooks::CreatureEvents>(EVENT, creature->GET_GUID(), creature->GetInstanceId());
+    if (!CreatureEventBindings->HasBindingsFor(entry_key) && !CreatureUniqueBindings->HasBindingsFor(unique_key))
+        return;
+
+    CallHookHandlers<NRESULTS>(CreatureEventBindings, CreatureUniqueBindings, entry_key, unique_key, on_results, args...);
+}
+
+template<auto EVENT, typename C, typename... Args>
+void Forge::CallCreatureHook(C const* creature, Args const&... args)
+{
+    CallCreatureHookResults<EVENT, 0>(creature, [](int, int) { }, args...);
+}
+
+template<auto EVENT, typename C, typename... Args>
+bool Forge::CallCreatureHookBool(C const* creature, bool default_value, Args const&... args)
+{
+    bool result = default_value;
+    CallCreatureHookResults<EVENT, 1>(creature, [&](int r, int)
+    {
+        if (lua_isboolean(L, r) && (lua_toboolean(L, r) == 1) != default_value)
+            result = !default_value;
+    }, args...);
+    return result;
+}
+
 #endif // _HOOK_HELPERS_H
@@ -17,6 +17,10 @@
  *
  * A. If results will be IGNORED:
  *
+ *     // Return early if nothing is bound to the event at all.
+ *     if (!BoundHooks->IsBound(REGTYPE_WHATEVER, SOME_EVENT_TYPE))
+ *         return;
+ *
  *     // Return early if there are no bindings.
  *     if (!WhateverBindings->HasBindingsFor(SOME_EVENT_TYPE))
  *         return;
@@ -35,6 +39,10 @@
  *
  * B. If results will be USED:
  *
+ *     // Return early if nothing is bound to the event at all.
+ *     if (!BoundHooks->IsBound(REGTYPE_WHATEVER, SOME_EVENT_TYPE))
+ *          return;
+ *
  *     // Return early if there are no bindings.
  *     if (!WhateverBindings->HasBindingsFor(SOME_EVENT_TYPE))
  *          return;
@@ -69,6 +77,21 @@
  *
  *     // Clean-up the stack. Argument is 3 because we did 3 Pushes.
  *     CleanUpStack(3);
+ *
+ *
+ * C. Hooks for events stored in an `EventKey` store or for creature events can use the
+ *    typed helpers in HookHelpers.h instead, which do all of the above with the argument
+ *    count fixed at compile time:
+ *
+ *     // Results IGNORED.
+ *     CallHook<SOME_EVENT_TYPE>(a, b, c);
+ *
+ *     // Results USED, 2 per handler. `r` is the index of the first result,
+ *     //   `args` the index of `a`, or 0 when no handler follows (see `ReplaceHookArgument`).
+ *     CallHookResults<SOME_EVENT_TYPE, 2>([&](int r, int args)
+ *     {
+ *         int first = CHECKVAL<int>(r + 0);
+ *     }, a, b, c);
  */
 
 namespace Hooks
@@ -20,6 +20,8 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT, AI) \
+    if (!BoundHooks->IsBoundAny(REGTYPE_MAP, REGTYPE_INSTANCE, EVENT))\
+        return;\
     auto mapKey = EntryKey<InstanceEvents>(EVENT, AI->instance->GetId());\
     auto instanceKey = EntryKey<InstanceEvents>(EVENT, AI->instance->GetInstanceId());\
     if (!MapEventBindings->HasBindingsFor(mapKey) && !InstanceEventBindings->HasBindingsFor(instanceKey))\
@@ -28,6 +30,8 @@ using namespace Hooks;
     HookPush<Map>(AI->instance)
 
 #define START_HOOK_WITH_RETVAL(EVENT, AI, RETVAL) \
+    if (!BoundHooks->IsBoundAny(REGTYPE_MAP, REGTYPE_INSTANCE, EVENT))\
+        return RETVAL;\
     auto mapKey = EntryKey<InstanceEvents>(EVENT, AI->instance->GetId());\
     auto instanceKey = EntryKey<InstanceEvents>(EVENT, AI->instance->GetInstanceId());\
     if (!MapEventBindings->HasBindingsFor(mapKey) && !InstanceEventBindings->HasBindingsFor(instanceKey))\
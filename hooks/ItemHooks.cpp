@@ -19,11 +19,15 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT, ENTRY) \
+    if (!BoundHooks->IsBound(REGTYPE_ITEM, EVENT))\
+        return;\
     auto key = EntryKey<ItemEvents>(EVENT, ENTRY);\
     if (!ItemEventBindings->HasBindingsFor(key))\
         return;
 
 #define START_HOOK_WITH_RETVAL(EVENT, ENTRY, RETVAL) \
+    if (!BoundHooks->IsBound(REGTYPE_ITEM, EVENT))\
+        return RETVAL;\
     auto key = EntryKey<ItemEvents>(EVENT, ENTRY);\
     if (!ItemEventBindings->HasBindingsFor(key))\
         return RETVAL;
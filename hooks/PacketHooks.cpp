@@ -19,11 +19,13 @@
 using namespace Hooks;
 
 #define START_HOOK_SERVER(EVENT) \
-    auto key = EventKey<ServerEvents>(EVENT);\
-    if (!ServerEventBindings->HasBindingsFor(key))\
-        return;
+    if (!BoundHooks->IsBound(REGTYPE_SERVER, EVENT))\
+        return;\
+    auto key = EventKey<ServerEvents>(EVENT);
 
 #define START_HOOK_PACKET(EVENT, OPCODE) \
+    if (!BoundHooks->IsBound(REGTYPE_PACKET, EVENT))\
+        return;\
     auto key = EntryKey<PacketEvents>(EVENT, OPCODE);\
     if (!PacketEventBindings->HasBindingsFor(key))\
         return;
@@ -21,58 +21,27 @@
 
 using namespace Hooks;
 
-#define START_HOOK(EVENT) \
-    auto key = EventKey<PlayerEvents>(EVENT);\
-    if (!PlayerEventBindings->HasBindingsFor(key))\
-        return;
-
-#define START_HOOK_WITH_RETVAL(EVENT, RETVAL) \
-    auto key = EventKey<PlayerEvents>(EVENT);\
-    if (!PlayerEventBindings->HasBindingsFor(key))\
-        return RETVAL;
-
 void Forge::OnLearnTalents(Player* pPlayer, uint32 talentId, uint32 talentRank, uint32 spellid)
 {
-    START_HOOK(PLAYER_EVENT_ON_LEARN_TALENTS);
-    HookPush(pPlayer);
-    HookPush(talentId);
-    HookPush(talentRank);
-    HookPush(spellid);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_LEARN_TALENTS>(pPlayer, talentId, talentRank, spellid);
 }
 
 void Forge::OnSkillChange(Player* pPlayer, uint32 skillId, uint32 skillValue)
 {
-    START_HOOK(PLAYER_EVENT_ON_SKILL_CHANGE);
-    HookPush(pPlayer);
-    HookPush(skillId);
-    HookPush(skillValue);
-    int valueIndex = lua_gettop(L) - 1;
-    int n = SetupStack(PlayerEventBindings, key, 3);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_SKILL_CHANGE, 1>([&](int r, int args)
     {
-        int r = CallOneFunction(n--, 3, 1);
-
         if (lua_isnumber(L, r))
         {
             skillValue = CHECKVAL<uint32>(r);
             // Update the stack for subsequent calls.
-            ReplaceArgument(skillValue, valueIndex);
+            ReplaceHookArgument(args, 2, skillValue);
         }
-
-        lua_pop(L, 1);
-    }
-
-    CleanUpStack(3);
+    }, pPlayer, skillId, skillValue);
 }
 
 void Forge::OnLearnSpell(Player* pPlayer, uint32 spellId)
 {
-    START_HOOK(PLAYER_EVENT_ON_LEARN_SPELL);
-    HookPush(pPlayer);
-    HookPush(spellId);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_LEARN_SPELL>(pPlayer, spellId);
 }
 
 bool Forge::OnCommand(Player* player, const char* text)
@@ -94,437 +63,299 @@ bool Forge::OnCommand(Player* player, const char* text)
 
             return false;
         }
+
+        // .forge profile start|stop|dump [mapId] and .forge sample start|stop|dump [mapId]
+        const std::string profile_command = "forge profile";
+        const std::string sample_command = "forge sample";
+        bool profile = reload.find(profile_command) == 0;
+        bool sample = reload.find(sample_command) == 0;
+        if (profile || sample)
+        {
+            std::string args = reload.substr(profile ? profile_command.length() : sample_command.length());
+            args.erase(0, args.find_first_not_of(' '));
+            std::string action = args.substr(0, args.find(' '));
+
+            int mapId = RELOAD_ALL_STATES;
+            if (action.length() < args.length())
+                mapId = strtol(args.c_str() + action.length(), nullptr, 10);
+
+            if (action == "start")
+                sForgeLoader->RequestProfileForMap(profile ? PROFILE_REQUEST_START : PROFILE_REQUEST_SAMPLE_START, mapId);
+            else if (action == "stop")
+                sForgeLoader->RequestProfileForMap(profile ? PROFILE_REQUEST_STOP : PROFILE_REQUEST_SAMPLE_STOP, mapId);
+            else if (action == "dump")
+                sForgeLoader->RequestProfileForMap(profile ? PROFILE_REQUEST_DUMP : PROFILE_REQUEST_SAMPLE_DUMP, mapId);
+            else
+                FORGE_LOG_ERROR("[Forge]: Unknown action `%s`, use start, stop or dump", action.c_str());
+
+            return false;
+        }
+
+        // .forge stats [mapId]
+        const std::string stats_command = "forge stats";
+        if (reload.find(stats_command) == 0)
+        {
+            int mapId = RELOAD_ALL_STATES;
+            std::string args = reload.substr(stats_command.length());
+            if (!args.empty())
+                mapId = strtol(args.c_str(), nullptr, 10);
+
+            sForgeLoader->RequestProfileForMap(PROFILE_REQUEST_STATS, mapId);
+
+            return false;
+        }
     }
 
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_COMMAND, true);
-    HookPush(player);
-    HookPush(text);
-    return CallAllFunctionsBool(PlayerEventBindings, key, true);
+    return CallHookBool<PLAYER_EVENT_ON_COMMAND>(true, player, text);
 }
 
 void Forge::OnLootItem(Player* pPlayer, Item* pItem, uint32 count, ObjectGuid guid)
 {
-    START_HOOK(PLAYER_EVENT_ON_LOOT_ITEM);
-    HookPush(pPlayer);
-    HookPush(pItem);
-    HookPush(count);
-    HookPush(guid);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_LOOT_ITEM>(pPlayer, pItem, count, guid);
 }
 
 void Forge::OnLootMoney(Player* pPlayer, uint32 amount)
 {
-    START_HOOK(PLAYER_EVENT_ON_LOOT_MONEY);
-    HookPush(pPlayer);
-    HookPush(amount);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_LOOT_MONEY>(pPlayer, amount);
 }
 
 void Forge::OnFirstLogin(Player* pPlayer)
 {
-    START_HOOK(PLAYER_EVENT_ON_FIRST_LOGIN);
-    HookPush(pPlayer);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_FIRST_LOGIN>(pPlayer);
 }
 
 void Forge::OnRepop(Player* pPlayer)
 {
-    START_HOOK(PLAYER_EVENT_ON_REPOP);
-    HookPush(pPlayer);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_REPOP>(pPlayer);
 }
 
 void Forge::OnResurrect(Player* pPlayer)
 {
-    START_HOOK(PLAYER_EVENT_ON_RESURRECT);
-    HookPush(pPlayer);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_RESURRECT>(pPlayer);
 }
 
 void Forge::OnQuestAbandon(Player* pPlayer, uint32 questId)
 {
-    START_HOOK(PLAYER_EVENT_ON_QUEST_ABANDON);
-    HookPush(pPlayer);
-    HookPush(questId);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_QUEST_ABANDON>(pPlayer, questId);
 }
 
 void Forge::OnQuestStatusChanged(Player* pPlayer, uint32 questId, uint8 status)
 {
-    START_HOOK(PLAYER_EVENT_ON_QUEST_STATUS_CHANGED);
-    HookPush(pPlayer);
-    HookPush(questId);
-    HookPush(status);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_QUEST_STATUS_CHANGED>(pPlayer, questId, status);
 }
 
 void Forge::OnEquip(Player* pPlayer, Item* pItem, uint8 bag, uint8 slot)
 {
-    START_HOOK(PLAYER_EVENT_ON_EQUIP);
-    HookPush(pPlayer);
-    HookPush(pItem);
-    HookPush(bag);
-    HookPush(slot);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_EQUIP>(pPlayer, pItem, bag, slot);
 }
 
 InventoryResult Forge::OnCanUseItem(const Player* pPlayer, uint32 itemEntry)
 {
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_CAN_USE_ITEM, EQUIP_ERR_OK);
     InventoryResult result = EQUIP_ERR_OK;
-    HookPush(pPlayer);
-    HookPush(itemEntry);
-    int n = SetupStack(PlayerEventBindings, key, 2);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_CAN_USE_ITEM, 1>([&](int r, int)
     {
-        int r = CallOneFunction(n--, 2, 1);
-
         if (lua_isnumber(L, r))
             result = (InventoryResult)CHECKVAL<uint32>(r);
-
-        lua_pop(L, 1);
-    }
-
-    CleanUpStack(2);
+    }, pPlayer, itemEntry);
     return result;
 }
 void Forge::OnPlayerEnterCombat(Player* pPlayer, Unit* pEnemy)
 {
-    START_HOOK(PLAYER_EVENT_ON_ENTER_COMBAT);
-    HookPush(pPlayer);
-    HookPush(pEnemy);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_ENTER_COMBAT>(pPlayer, pEnemy);
 }
 
 void Forge::OnPlayerLeaveCombat(Player* pPlayer)
 {
-    START_HOOK(PLAYER_EVENT_ON_LEAVE_COMBAT);
-    HookPush(pPlayer);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_LEAVE_COMBAT>(pPlayer);
 }
 
 void Forge::OnPVPKill(Player* pKiller, Player* pKilled)
 {
-    START_HOOK(PLAYER_EVENT_ON_KILL_PLAYER);
-    HookPush(pKiller);
-    HookPush(pKilled);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_KILL_PLAYER>(pKiller, pKilled);
 }
 
 void Forge::OnCreatureKill(Player* pKiller, Creature* pKilled)
 {
-    START_HOOK(PLAYER_EVENT_ON_KILL_CREATURE);
-    HookPush(pKiller);
-    HookPush(pKilled);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_KILL_CREATURE>(pKiller, pKilled);
 }
 
 void Forge::OnPlayerKilledByCreature(Creature* pKiller, Player* pKilled)
 {
-    START_HOOK(PLAYER_EVENT_ON_KILLED_BY_CREATURE);
-    HookPush(pKiller);
-    HookPush(pKilled);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_KILLED_BY_CREATURE>(pKiller, pKilled);
 }
 
 void Forge::OnPlayerKilledByEnvironment(Player* pKilled, uint8 damageType)
 {
-    START_HOOK(PLAYER_EVENT_ON_ENVIRONMENTAL_DEATH);
-    HookPush(pKilled);
-    HookPush(damageType);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_ENVIRONMENTAL_DEATH>(pKilled, damageType);
 }
 
 void Forge::OnLevelChanged(Player* pPlayer, uint8 oldLevel)
 {
-    START_HOOK(PLAYER_EVENT_ON_LEVEL_CHANGE);
-    HookPush(pPlayer);
-    HookPush(oldLevel);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_LEVEL_CHANGE>(pPlayer, oldLevel);
 }
 
 void Forge::OnFreeTalentPointsChanged(Player* pPlayer, uint32 newPoints)
 {
-    START_HOOK(PLAYER_EVENT_ON_TALENTS_CHANGE);
-    HookPush(pPlayer);
-    HookPush(newPoints);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_TALENTS_CHANGE>(pPlayer, newPoints);
 }
 
 void Forge::OnTalentsReset(Player* pPlayer, bool noCost)
 {
-    START_HOOK(PLAYER_EVENT_ON_TALENTS_RESET);
-    HookPush(pPlayer);
-    HookPush(noCost);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_TALENTS_RESET>(pPlayer, noCost);
 }
 
 void Forge::OnMoneyChanged(Player* pPlayer, int32& amount)
 {
-    START_HOOK(PLAYER_EVENT_ON_MONEY_CHANGE);
-    HookPush(pPlayer);
-    HookPush(amount);
-    int amountIndex = lua_gettop(L);
-    int n = SetupStack(PlayerEventBindings, key, 2);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_MONEY_CHANGE, 1>([&](int r, int args)
     {
-        int r = CallOneFunction(n--, 2, 1);
-
         if (lua_isnumber(L, r))
         {
             amount = CHECKVAL<int32>(r);
             // Update the stack for subsequent calls.
-            ReplaceArgument(amount, amountIndex);
+            ReplaceHookArgument(args, 1, amount);
         }
-
-        lua_pop(L, 1);
-    }
-
-    CleanUpStack(2);
+    }, pPlayer, amount);
 }
 
 #if FORGE_EXPANSION >= EXP_CATA
 void Forge::OnMoneyChanged(Player* pPlayer, int64& amount)
 {
-    START_HOOK(PLAYER_EVENT_ON_MONEY_CHANGE);
-    HookPush(pPlayer);
-    HookPush(amount);
-    int amountIndex = lua_gettop(L);
-    int n = SetupStack(PlayerEventBindings, key, 2);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_MONEY_CHANGE, 1>([&](int r, int args)
     {
-        int r = CallOneFunction(n--, 2, 1);
-
         if (lua_isnumber(L, r))
         {
             amount = CHECKVAL<int32>(r);
             // Update the stack for subsequent calls.
-            ReplaceArgument(amount, amountIndex);
+            ReplaceHookArgument(args, 1, amount);
         }
-
-        lua_pop(L, 1);
-    }
-
-    CleanUpStack(2);
+    }, pPlayer, amount);
 }
 #endif
 
 void Forge::OnGiveXP(Player* pPlayer, uint32& amount, Unit* pVictim)
 {
-    START_HOOK(PLAYER_EVENT_ON_GIVE_XP);
-    HookPush(pPlayer);
-    HookPush(amount);
-    HookPush(pVictim);
-    int amountIndex = lua_gettop(L) - 1;
-    int n = SetupStack(PlayerEventBindings, key, 3);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_GIVE_XP, 1>([&](int r, int args)
     {
-        int r = CallOneFunction(n--, 3, 1);
-
         if (lua_isnumber(L, r))
         {
             amount = CHECKVAL<uint32>(r);
             // Update the stack for subsequent calls.
-            ReplaceArgument(amount, amountIndex);
+            ReplaceHookArgument(args, 1, amount);
         }
-
-        lua_pop(L, 1);
-    }
-
-    CleanUpStack(3);
+    }, pPlayer, amount, pVictim);
 }
 
 void Forge::OnReputationChange(Player* pPlayer, uint32 factionID, int32& standing, bool incremental)
 {
-    START_HOOK(PLAYER_EVENT_ON_REPUTATION_CHANGE);
-    HookPush(pPlayer);
-    HookPush(factionID);
-    HookPush(standing);
-    HookPush(incremental);
-    int standingIndex = lua_gettop(L) - 1;
-    int n = SetupStack(PlayerEventBindings, key, 4);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_REPUTATION_CHANGE, 1>([&](int r, int args)
     {
-        int r = CallOneFunction(n--, 4, 1);
-
         if (lua_isnumber(L, r))
         {
             standing = CHECKVAL<int32>(r);
             // Update the stack for subsequent calls.
-            ReplaceArgument(standing, standingIndex);
+            ReplaceHookArgument(args, 2, standing);
         }
-
-        lua_pop(L, 1);
-    }
-
-    CleanUpStack(4);
+    }, pPlayer, factionID, standing, incremental);
 }
 
 void Forge::OnDuelRequest(Player* pTarget, Player* pChallenger)
 {
-    START_HOOK(PLAYER_EVENT_ON_DUEL_REQUEST);
-    HookPush(pTarget);
-    HookPush(pChallenger);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_DUEL_REQUEST>(pTarget, pChallenger);
 }
 
 void Forge::OnDuelStart(Player* pStarter, Player* pChallenger)
 {
-    START_HOOK(PLAYER_EVENT_ON_DUEL_START);
-    HookPush(pStarter);
-    HookPush(pChallenger);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_DUEL_START>(pStarter, pChallenger);
 }
 
 void Forge::OnDuelEnd(Player* pWinner, Player* pLoser, DuelCompleteType type)
 {
-    START_HOOK(PLAYER_EVENT_ON_DUEL_END);
-    HookPush(pWinner);
-    HookPush(pLoser);
-    HookPush(type);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_DUEL_END>(pWinner, pLoser, type);
 }
 
 void Forge::OnEmote(Player* pPlayer, uint32 emote)
 {
-    START_HOOK(PLAYER_EVENT_ON_EMOTE);
-    HookPush(pPlayer);
-    HookPush(emote);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_EMOTE>(pPlayer, emote);
 }
 
 void Forge::OnTextEmote(Player* pPlayer, uint32 textEmote, uint32 emoteNum, ObjectGuid guid)
 {
-    START_HOOK(PLAYER_EVENT_ON_TEXT_EMOTE);
-    HookPush(pPlayer);
-    HookPush(textEmote);
-    HookPush(emoteNum);
-    HookPush(guid);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_TEXT_EMOTE>(pPlayer, textEmote, emoteNum, guid);
 }
 
 void Forge::OnSpellCast(Player* pPlayer, Spell* pSpell, bool skipCheck)
 {
-    START_HOOK(PLAYER_EVENT_ON_SPELL_CAST);
-    HookPush(pPlayer);
-    HookPush(pSpell);
-    HookPush(skipCheck);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_SPELL_CAST>(pPlayer, pSpell, skipCheck);
 }
 
 void Forge::OnLogin(Player* pPlayer)
 {
-    START_HOOK(PLAYER_EVENT_ON_LOGIN);
-    HookPush(pPlayer);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_LOGIN>(pPlayer);
 }
 
 void Forge::OnLogout(Player* pPlayer)
 {
-    START_HOOK(PLAYER_EVENT_ON_LOGOUT);
-    HookPush(pPlayer);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_LOGOUT>(pPlayer);
 }
 
 void Forge::OnCreate(Player* pPlayer)
 {
-    START_HOOK(PLAYER_EVENT_ON_CHARACTER_CREATE);
-    HookPush(pPlayer);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_CHARACTER_CREATE>(pPlayer);
 }
 
 void Forge::OnDelete(uint32 guidlow)
 {
-    START_HOOK(PLAYER_EVENT_ON_CHARACTER_DELETE);
-    HookPush(guidlow);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_CHARACTER_DELETE>(guidlow);
 }
 
 void Forge::OnSave(Player* pPlayer)
 {
-    START_HOOK(PLAYER_EVENT_ON_SAVE);
-    HookPush(pPlayer);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_SAVE>(pPlayer);
 }
 
 void Forge::OnBindToInstance(Player* pPlayer, Difficulty difficulty, uint32 mapid, bool permanent)
 {
-    START_HOOK(PLAYER_EVENT_ON_BIND_TO_INSTANCE);
-    HookPush(pPlayer);
-    HookPush(difficulty);
-    HookPush(mapid);
-    HookPush(permanent);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_BIND_TO_INSTANCE>(pPlayer, difficulty, mapid, permanent);
 }
 
 void Forge::OnUpdateZone(Player* pPlayer, uint32 newZone, uint32 newArea)
 {
-    START_HOOK(PLAYER_EVENT_ON_UPDATE_ZONE);
-    HookPush(pPlayer);
-    HookPush(newZone);
-    HookPush(newArea);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_UPDATE_ZONE>(pPlayer, newZone, newArea);
 }
 
 void Forge::OnUpdateArea(Player* pPlayer, uint32 oldArea, uint32 newArea)
 {
-    START_HOOK(PLAYER_EVENT_ON_UPDATE_AREA);
-    HookPush(pPlayer);
-    HookPush(oldArea);
-    HookPush(newArea);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_UPDATE_AREA>(pPlayer, oldArea, newArea);
 }
 
 void Forge::OnMapChanged(Player* player)
 {
-    START_HOOK(PLAYER_EVENT_ON_MAP_CHANGE);
-    HookPush(player);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_MAP_CHANGE>(player);
 }
 
 void Forge::OnAchievementComplete(Player* player, uint32 achievementId)
 {
-    START_HOOK(PLAYER_EVENT_ON_ACHIEVEMENT_COMPLETE);
-    HookPush(player);
-    HookPush(achievementId);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_ACHIEVEMENT_COMPLETE>(player, achievementId);
 }
 
 bool Forge::OnTradeInit(Player* trader, Player* tradee)
 {
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_TRADE_INIT, true);
-    HookPush(trader);
-    HookPush(tradee);
-    return CallAllFunctionsBool(PlayerEventBindings, key, true);
+    return CallHookBool<PLAYER_EVENT_ON_TRADE_INIT>(true, trader, tradee);
 }
 
 bool Forge::OnTradeAccept(Player* trader, Player* tradee)
 {
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_TRADE_ACCEPT, true);
-    HookPush(trader);
-    HookPush(tradee);
-    return CallAllFunctionsBool(PlayerEventBindings, key, true);
+    return CallHookBool<PLAYER_EVENT_ON_TRADE_ACCEPT>(true, trader, tradee);
 }
 
 bool Forge::OnSendMail(Player* sender, ObjectGuid recipientGuid)
 {
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_SEND_MAIL, true);
-    HookPush(sender);
-    HookPush(recipientGuid);
-    return CallAllFunctionsBool(PlayerEventBindings, key, true);
+    return CallHookBool<PLAYER_EVENT_ON_SEND_MAIL>(true, sender, recipientGuid);
 }
 
 void Forge::OnDiscoverArea(Player* player, uint32 area)
 {
-    START_HOOK(PLAYER_EVENT_ON_DISCOVER_AREA);
-    HookPush(player);
-    HookPush(area);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_DISCOVER_AREA>(player, area);
 }
 
 bool Forge::OnChat(Player* pPlayer, uint32 type, uint32 lang, std::string& msg)
@@ -532,28 +363,15 @@ bool Forge::OnChat(Player* pPlayer, uint32 type, uint32 lang, std::string& msg)
     if (lang == LANG_ADDON)
         return OnAddonMessage(pPlayer, type, msg, NULL, NULL, NULL, NULL);
 
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_CHAT, true);
     bool result = true;
-    HookPush(pPlayer);
-    HookPush(msg);
-    HookPush(type);
-    HookPush(lang);
-    int n = SetupStack(PlayerEventBindings, key, 4);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_CHAT, 2>([&](int r, int)
     {
-        int r = CallOneFunction(n--, 4, 2);
-
         if (lua_isboolean(L, r + 0) && !lua_toboolean(L, r + 0))
             result = false;
 
         if (lua_isstring(L, r + 1))
             msg = std::string(lua_tostring(L, r + 1));
-
-        lua_pop(L, 2);
-    }
-
-    CleanUpStack(4);
+    }, pPlayer, msg, type, lang);
     return result;
 }
 
@@ -562,29 +380,15 @@ bool Forge::OnChat(Player* pPlayer, uint32 type, uint32 lang, std::string& msg,
     if (lang == LANG_ADDON)
         return OnAddonMessage(pPlayer, type, msg, NULL, NULL, pGroup, NULL);
 
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_GROUP_CHAT, true);
     bool result = true;
-    HookPush(pPlayer);
-    HookPush(msg);
-    HookPush(type);
-    HookPush(lang);
-    HookPush(pGroup);
-    int n = SetupStack(PlayerEventBindings, key, 5);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_GROUP_CHAT, 2>([&](int r, int)
     {
-        int r = CallOneFunction(n--, 5, 2);
-
         if (lua_isboolean(L, r + 0) && !lua_toboolean(L, r + 0))
             result = false;
 
         if (lua_isstring(L, r + 1))
             msg = std::string(lua_tostring(L, r + 1));
-
-        lua_pop(L, 2);
-    }
-
-    CleanUpStack(5);
+    }, pPlayer, msg, type, lang, pGroup);
     return result;
 }
 
@@ -593,29 +397,15 @@ bool Forge::OnChat(Player* pPlayer, uint32 type, uint32 lang, std::string& msg,
     if (lang == LANG_ADDON)
         return OnAddonMessage(pPlayer, type, msg, NULL, pGuild, NULL, NULL);
 
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_GUILD_CHAT, true);
     bool result = true;
-    HookPush(pPlayer);
-    HookPush(msg);
-    HookPush(type);
-    HookPush(lang);
-    HookPush(pGuild);
-    int n = SetupStack(PlayerEventBindings, key, 5);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_GUILD_CHAT, 2>([&](int r, int)
     {
-        int r = CallOneFunction(n--, 5, 2);
-
         if (lua_isboolean(L, r + 0) && !lua_toboolean(L, r + 0))
             result = false;
 
         if (lua_isstring(L, r + 1))
             msg = std::string(lua_tostring(L, r + 1));
-
-        lua_pop(L, 2);
-    }
-
-    CleanUpStack(5);
+    }, pPlayer, msg, type, lang, pGuild);
     return result;
 }
 
@@ -624,29 +414,15 @@ bool Forge::OnChat(Player* pPlayer, uint32 type, uint32 lang, std::string& msg,
     if (lang == LANG_ADDON)
         return OnAddonMessage(pPlayer, type, msg, NULL, NULL, NULL, pChannel);
 
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_CHANNEL_CHAT, true);
     bool result = true;
-    HookPush(pPlayer);
-    HookPush(msg);
-    HookPush(type);
-    HookPush(lang);
-    HookPush(pChannel->GetChannelId());
-    int n = SetupStack(PlayerEventBindings, key, 5);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_CHANNEL_CHAT, 2>([&](int r, int)
     {
-        int r = CallOneFunction(n--, 5, 2);
-
         if (lua_isboolean(L, r + 0) && !lua_toboolean(L, r + 0))
             result = false;
 
         if (lua_isstring(L, r + 1))
             msg = std::string(lua_tostring(L, r + 1));
-
-        lua_pop(L, 2);
-    }
-
-    CleanUpStack(5);
+    }, pPlayer, msg, type, lang, pChannel->GetChannelId());
     return result;
 }
 
@@ -655,61 +431,29 @@ bool Forge::OnChat(Player* pPlayer, uint32 type, uint32 lang, std::string& msg,
     if (lang == LANG_ADDON)
         return OnAddonMessage(pPlayer, type, msg, pReceiver, NULL, NULL, NULL);
 
-    START_HOOK_WITH_RETVAL(PLAYER_EVENT_ON_WHISPER, true);
     bool result = true;
-    HookPush(pPlayer);
-    HookPush(msg);
-    HookPush(type);
-    HookPush(lang);
-    HookPush(pReceiver);
-    int n = SetupStack(PlayerEventBindings, key, 5);
-
-    while (n > 0)
+    CallHookResults<PLAYER_EVENT_ON_WHISPER, 2>([&](int r, int)
     {
-        int r = CallOneFunction(n--, 5, 2);
-
         if (lua_isboolean(L, r + 0) && !lua_toboolean(L, r + 0))
             result = false;
 
         if (lua_isstring(L, r + 1))
             msg = std::string(lua_tostring(L, r + 1));
-
-        lua_pop(L, 2);
-    }
-
-    CleanUpStack(5);
+    }, pPlayer, msg, type, lang, pReceiver);
     return result;
 }
 
 void Forge::OnPlayerItemMove(Player* pPlayer, uint8 sourceBag, uint8 sourceSlot, uint8 destBag, uint8 destSlot, Item* itemSource, Item* itemDest)
 {
-    START_HOOK(PLAYER_EVENT_ON_ITEM_MOVE);
-    HookPush(pPlayer);
-    HookPush(sourceBag);
-    HookPush(sourceSlot);
-    HookPush(destBag);
-    HookPush(destSlot);
-    HookPush(itemSource);
-    HookPush(itemDest);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_ITEM_MOVE>(pPlayer, sourceBag, sourceSlot, destBag, destSlot, itemSource, itemDest);
 }
 
 void Forge::OnPlayerUnEquipItem(Player* pPlayer, Item* pItem, uint8 slot)
 {
-    START_HOOK(PLAYER_EVENT_ON_UNEQUIP_ITEM);
-    HookPush(pPlayer);
-    HookPush(pItem);
-    HookPush(slot);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_UNEQUIP_ITEM>(pPlayer, pItem, slot);
 }
 
 void Forge::OnPlayerItemBuy(Player* pPlayer, Item* pItem, Creature* vendor, ItemTemplate const* item_template, uint32 count)
 {
-    START_HOOK(PLAYER_EVENT_ON_ITEM_BUY);
-    HookPush(pPlayer);
-    HookPush(pItem);
-    HookPush(vendor);
-    HookPush(item_template);
-    HookPush(count);
-    CallAllFunctions(PlayerEventBindings, key);
+    CallHook<PLAYER_EVENT_ON_ITEM_BUY>(pPlayer, pItem, vendor, item_template, count);
 }
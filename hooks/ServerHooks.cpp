@@ -20,14 +20,14 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT) \
-    auto key = EventKey<ServerEvents>(EVENT);\
-    if (!ServerEventBindings->HasBindingsFor(key))\
-        return;
+    if (!BoundHooks->IsBound(REGTYPE_SERVER, EVENT))\
+        return;\
+    auto key = EventKey<ServerEvents>(EVENT);
 
 #define START_HOOK_WITH_RETVAL(EVENT, RETVAL) \
-    auto key = EventKey<ServerEvents>(EVENT);\
-    if (!ServerEventBindings->HasBindingsFor(key))\
-        return RETVAL;
+    if (!BoundHooks->IsBound(REGTYPE_SERVER, EVENT))\
+        return RETVAL;\
+    auto key = EventKey<ServerEvents>(EVENT);
 
 bool Forge::OnAddonMessage(Player* sender, uint32 type, std::string& msg, Player* receiver, Guild* guild, Group* group, Channel* channel)
 {
@@ -70,6 +70,15 @@ void Forge::OnTimedEvent(int funcRef, uint32 delay, uint32 calls, WorldObject* o
     // Get function
     lua_rawgeti(L, LUA_REGISTRYINDEX, funcRef);
 
+    // Coroutine suspended by Sleep, the event is removed after this call
+    if (lua_type(L, -1) == LUA_TTHREAD)
+    {
+        ResumeCoroutine(lua_tothread(L, -1), 0);
+        lua_pop(L, 1);
+        ASSERT(!event_level);
+        return;
+    }
+
     // Push parameters
     Push(funcRef);
     Push(delay);
@@ -317,6 +326,7 @@ void Forge::OnPlayerEnter(Map* map, Player* player)
 
 void Forge::OnPlayerLeave(Map* map, Player* player)
 {
+    eventMgr->RemoveObjectEvents(player->GET_GUID());
     START_HOOK(MAP_EVENT_ON_PLAYER_LEAVE);
     HookPush(map);
     HookPush(player);
@@ -19,11 +19,15 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT, SPELL) \
+    if (!BoundHooks->IsBound(REGTYPE_SPELL, EVENT))\
+        return;\
     auto key = EntryKey<SpellEvents>(EVENT, SPELL->m_spellInfo->Id);\
     if (!SpellEventBindings->HasBindingsFor(key))\
         return;
 
 #define START_HOOK_WITH_RETVAL(EVENT, SPELL, RETVAL) \
+    if (!BoundHooks->IsBound(REGTYPE_SPELL, EVENT))\
+        return RETVAL;\
     auto key = EntryKey<SpellEvents>(EVENT, SPELL->m_spellInfo->Id);\
     if (!SpellEventBindings->HasBindingsFor(key))\
         return RETVAL;
@@ -20,9 +20,9 @@
 using namespace Hooks;
 
 #define START_HOOK(EVENT) \
-    auto key = EventKey<VehicleEvents>(EVENT);\
-    if (!VehicleEventBindings->HasBindingsFor(key))\
-        return;
+    if (!BoundHooks->IsBound(REGTYPE_VEHICLE, EVENT))\
+        return;\
+    auto key = EventKey<VehicleEvents>(EVENT);
 
 void Forge::OnInstall(Vehicle* vehicle)
 {
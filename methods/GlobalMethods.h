@@ -1330,11 +1330,18 @@ namespace LuaGlobalFunctions
      *     end)
      *
      * @param string sql : query to execute asynchronously
-     * @param function callback : the callback function to be called with the query results
+     * @param function callback : the callback function to be called with the query results, can be left out in a coroutine to get the results from `Await`, see [Global:RunCoroutine]
      */
     int WorldDBQueryAsync(Forge* F)
     {
         const char* query = F->CHECKVAL<const char*>(1);
+
+        // without a callback the running coroutine receives the result in Await
+        if (lua_isnoneornil(F->L, 2) && F->CanSuspendCoroutine())
+        {
+            F->AwaitQuery(WorldDatabase.AsyncQuery(query));
+            return 0;
+        }
         luaL_checktype(F->L, 2, LUA_TFUNCTION);
 
         // Push the Lua function onto the stack and create a reference
@@ -1349,7 +1356,7 @@ namespace LuaGlobalFunctions
         }
 
         // Add an asynchronous query callback
-        F->GetQueryProcessor().AddCallback(WorldDatabase.AsyncQuery(query).WithCallback([F, funcRef](QueryResult result)
+        F->AddQueryCallback(WorldDatabase.AsyncQuery(query), [F, funcRef](QueryResult result)
         {
             ForgeQuery* eq = result ? &result : nullptr;
 
@@ -1364,7 +1371,7 @@ namespace LuaGlobalFunctions
 
             // Unreference the Lua function
             luaL_unref(F->L, LUA_REGISTRYINDEX, funcRef);
-        }));
+        });
         return 0;
     }
 
@@ -1421,11 +1428,18 @@ namespace LuaGlobalFunctions
      * For an example see [Global:WorldDBQueryAsync].
      *
      * @param string sql : query to execute asynchronously
-     * @param function callback : the callback function to be called with the query results
+     * @param function callback : the callback function to be called with the query results, can be left out in a coroutine to get the results from `Await`, see [Global:RunCoroutine]
      */
     int CharDBQueryAsync(Forge* F)
     {
         const char* query = F->CHECKVAL<const char*>(1);
+
+        // without a callback the running coroutine receives the result in Await
+        if (lua_isnoneornil(F->L, 2) && F->CanSuspendCoroutine())
+        {
+            F->AwaitQuery(CharacterDatabase.AsyncQuery(query));
+            return 0;
+        }
         luaL_checktype(F->L, 2, LUA_TFUNCTION);
 
         // Push the Lua function onto the stack and create a reference
@@ -1440,7 +1454,7 @@ namespace LuaGlobalFunctions
         }
 
         // Add an asynchronous query callback
-        F->GetQueryProcessor().AddCallback(CharacterDatabase.AsyncQuery(query).WithCallback([F, funcRef](QueryResult result)
+        F->AddQueryCallback(CharacterDatabase.AsyncQuery(query), [F, funcRef](QueryResult result)
         {
             ForgeQuery* eq = result ? &result : nullptr;
 
@@ -1455,7 +1469,7 @@ namespace LuaGlobalFunctions
 
             // Unreference the Lua function
             luaL_unref(F->L, LUA_REGISTRYINDEX, funcRef);
-        }));
+        });
         return 0;
     }
 
@@ -1512,11 +1526,18 @@ namespace LuaGlobalFunctions
      * For an example see [Global:WorldDBQueryAsync].
      *
      * @param string sql : query to execute asynchronously
-     * @param function callback : the callback function to be called with the query results
+     * @param function callback : the callback function to be called with the query results, can be left out in a coroutine to get the results from `Await`, see [Global:RunCoroutine]
      */
     int AuthDBQueryAsync(Forge* F)
     {
         const char* query = F->CHECKVAL<const char*>(1);
+
+        // without a callback the running coroutine receives the result in Await
+        if (lua_isnoneornil(F->L, 2) && F->CanSuspendCoroutine())
+        {
+            F->AwaitQuery(LoginDatabase.AsyncQuery(query));
+            return 0;
+        }
         luaL_checktype(F->L, 2, LUA_TFUNCTION);
 
         // Push the Lua function onto the stack and create a reference
@@ -1531,7 +1552,7 @@ namespace LuaGlobalFunctions
         }
 
         // Add an asynchronous query callback
-        F->GetQueryProcessor().AddCallback(LoginDatabase.AsyncQuery(query).WithCallback([F, funcRef](QueryResult result)
+        F->AddQueryCallback(LoginDatabase.AsyncQuery(query), [F, funcRef](QueryResult result)
         {
             ForgeQuery* eq = result ? &result : nullptr;
 
@@ -1546,7 +1567,7 @@ namespace LuaGlobalFunctions
 
             // Unreference the Lua function
             luaL_unref(F->L, LUA_REGISTRYINDEX, funcRef);
-        }));
+        });
         return 0;
     }
 
@@ -1635,6 +1656,227 @@ namespace LuaGlobalFunctions
         return 0;
     }
 
+    /**
+     * Runs the function in a new coroutine with the passed arguments.
+     *
+     * Within the coroutine the following global functions suspend it, so work can be spread over several server ticks:
+     *
+     * - `Sleep(delay)` resumes the coroutine after `delay` milliseconds, the wait is a global timed event removed by [Global:RemoveEvents]
+     * - `NextTick()` resumes the coroutine on the next update of the Lua state
+     * - `Await(WorldDBQueryAsync(sql))` resumes the coroutine with the result of an asynchronous query that was given no callback,
+     *    the same works for [Global:CharDBQueryAsync] and [Global:AuthDBQueryAsync]
+     *
+     * Objects such as a [Player] are no longer valid after the coroutine was suspended, store their GUID and fetch them again after resuming.
+     * The same goes for the [ForgeQuery] returned by `Await`, read the values you need from it before suspending again.
+     *
+     *     RunCoroutine(function(guid)
+     *         local results = Await(WorldDBQueryAsync("SELECT entry FROM creature_template LIMIT 10"))
+     *         local entry = results and results:GetUInt32(0)
+     *         Sleep(1000)
+     *         local player = GetPlayerByGUID(guid)
+     *         if player and entry then
+     *             player:SendBroadcastMessage("First entry is "..entry)
+     *         end
+     *     end, player:GetGUID())
+     *
+     * @param function function : function to run in the coroutine
+     * @param ... : arguments passed to the function
+     */
+    int RunCoroutine(Forge* F)
+    {
+        luaL_checktype(F->L, 1, LUA_TFUNCTION);
+
+        // copy the function and arguments as the thunk expects the stack to be left intact
+        int top = lua_gettop(F->L);
+        for (int i = 1; i <= top; ++i)
+            lua_pushvalue(F->L, i);
+        F->RunCoroutine(top - 1);
+        return 0;
+    }
+
+    /**
+     * Runs the function with the passed arguments later in the same server tick, or in a later one
+     * when the Lua state has spent its execution budget for the tick.
+     *
+     * The budget is set with `Forge.TickBudgetMs` in the config. The function runs in a coroutine like
+     * with [Global:RunCoroutine], so it can use `Sleep`, `NextTick` and `Await` too. On Lua 5.3 and newer
+     * a long running function is suspended when the budget runs out and continues on the next tick.
+     *
+     *     local function ProcessRows(rows)
+     *         for i = 1, #rows do
+     *             ...
+     *         end
+     *     end
+     *     Defer(ProcessRows, rows)
+     *
+     * @param function function : function to run
+     * @param ... : arguments passed to the function
+     */
+    int Defer(Forge* F)
+    {
+        luaL_checktype(F->L, 1, LUA_TFUNCTION);
+
+        // copy the function and arguments as the thunk expects the stack to be left intact
+        int top = lua_gettop(F->L);
+        for (int i = 1; i <= top; ++i)
+            lua_pushvalue(F->L, i);
+        F->Defer(top - 1);
+        return 0;
+    }
+
+    /**
+     * Returns the time the Lua state of the current map spent running Lua during the last server tick,
+     * the tick budget and the amount of functions waiting to run from [Global:Defer].
+     *
+     * The time is only measured when `Forge.TickBudgetMs` is set in the config, otherwise it is 0.
+     *
+     * @return number usage : milliseconds spent running Lua during the last tick
+     * @return uint32 budget : milliseconds Lua can run each tick, 0 if there is no budget
+     * @return uint32 deferred : amount of deferred functions waiting to run
+     */
+    int GetTickBudgetUsage(Forge* F)
+    {
+        F->Push(F->GetLastTickUsage() / 1000.0);
+        F->Push(uint32(F->GetTickBudget() / 1000));
+        F->Push(uint32(F->GetDeferredJobCount()));
+        return 3;
+    }
+
+    /**
+     * Returns a table of the handlers the watchdog aborted in the Lua state of the current map.
+     *
+     * The watchdog aborts a call into Lua with an error when it runs more instructions than `Forge.WatchdogInstructions`
+     * or longer than `Forge.WatchdogMs` set in the config. The keys of the table are the sources of the handlers
+     * as `file:line` and the values the amount of times they were aborted.
+     *
+     * @return table aborts : aborted handler counts by source
+     */
+    int GetWatchdogAborts(Forge* F)
+    {
+        const std::unordered_map<std::string, uint32>& aborts = F->GetWatchdogAborts();
+
+        lua_createtable(F->L, 0, aborts.size());
+        for (std::unordered_map<std::string, uint32>::const_iterator it = aborts.begin(); it != aborts.end(); ++it)
+        {
+            F->Push(it->first);
+            F->Push(it->second);
+            lua_rawset(F->L, -3);
+        }
+        return 1;
+    }
+
+    /**
+     * Returns the handler timings collected since the profiler was started with `.forge profile start`
+     * for the Lua state of the current map, sorted by total time.
+     *
+     * Each entry of the returned array is a table with the fields `regtype`, `event` and `entry` of the hook,
+     * `source` of the handler as `file:line`, `calls`, `total` and `max` in microseconds and `histogram`,
+     * where element N counts the calls that took less than 2^(N-1) microseconds. Calls made outside of hooks,
+     * like timed events, have the `regtype` after the last register type.
+     *
+     * @return table profile : handler timings, empty if the profiler was never started
+     */
+    int GetForgeProfile(Forge* F)
+    {
+        std::vector<ForgeProfiler::Stats const*> stats = F->GetProfiler().GetStats();
+
+        lua_createtable(F->L, stats.size(), 0);
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            ForgeProfiler::Stats const* entry = stats[i];
+
+            // counts and times are pushed as numbers, 64 bit integers would be userdata on Lua 5.1 and 5.2
+            lua_createtable(F->L, 0, 8);
+            F->Push(entry->context.regtype);
+            lua_setfield(F->L, -2, "regtype");
+            F->Push(entry->context.event);
+            lua_setfield(F->L, -2, "event");
+            F->Push(entry->context.entry);
+            lua_setfield(F->L, -2, "entry");
+            F->Push(entry->source);
+            lua_setfield(F->L, -2, "source");
+            F->Push(double(entry->calls));
+            lua_setfield(F->L, -2, "calls");
+            F->Push(double(entry->total));
+            lua_setfield(F->L, -2, "total");
+            F->Push(double(entry->max));
+            lua_setfield(F->L, -2, "max");
+
+            lua_createtable(F->L, ForgeProfiler::HISTOGRAM_BUCKETS, 0);
+            for (uint32 bucket = 0; bucket < ForgeProfiler::HISTOGRAM_BUCKETS; ++bucket)
+            {
+                F->Push(double(entry->histogram[bucket]));
+                lua_rawseti(F->L, -2, bucket + 1);
+            }
+            lua_setfield(F->L, -2, "histogram");
+
+            lua_rawseti(F->L, -2, i + 1);
+        }
+        return 1;
+    }
+
+    /**
+     * Returns the metrics of the Lua state of the current map, the same ones `.forge stats` logs
+     * and `Forge.MetricsFile` writes.
+     *
+     * The returned table has the fields `memory` in bytes used by Lua, `gcCycles` completed by the garbage collector,
+     * `registryRefs`, `timers` scheduled, `pendingQueries` waiting for their callback, `waitingCoroutines` suspended
+     * by `NextTick` or `Await`, `deferredJobs`, `userdataPushes` and `userdataReuses` from the object cache,
+     * `reloads` and `runTime` in milliseconds the scripts took to run when the state was loaded.
+     *
+     * When `Forge.Metrics` is enabled in the config, `hooks` is an array of tables with the fields `regtype`, `event`,
+     * `calls` and `time` in microseconds, including the calls made by nested hooks. Calls made outside of hooks,
+     * like timed events, have the `regtype` after the last register type.
+     *
+     * @return table metrics
+     */
+    int GetForgeMetrics(Forge* F)
+    {
+        ForgeMetricsSnapshot metrics = F->GetMetrics();
+
+        // counters are pushed as numbers, 64 bit integers would be userdata on Lua 5.1 and 5.2
+        lua_createtable(F->L, 0, 12);
+        F->Push(double(metrics.memory));
+        lua_setfield(F->L, -2, "memory");
+        F->Push(double(metrics.gcCycles));
+        lua_setfield(F->L, -2, "gcCycles");
+        F->Push(metrics.registryRefs);
+        lua_setfield(F->L, -2, "registryRefs");
+        F->Push(metrics.timers);
+        lua_setfield(F->L, -2, "timers");
+        F->Push(metrics.pendingQueries);
+        lua_setfield(F->L, -2, "pendingQueries");
+        F->Push(metrics.waitingCoroutines);
+        lua_setfield(F->L, -2, "waitingCoroutines");
+        F->Push(metrics.deferredJobs);
+        lua_setfield(F->L, -2, "deferredJobs");
+        F->Push(double(metrics.userdataPushes));
+        lua_setfield(F->L, -2, "userdataPushes");
+        F->Push(double(metrics.userdataReuses));
+        lua_setfield(F->L, -2, "userdataReuses");
+        F->Push(metrics.reloads);
+        lua_setfield(F->L, -2, "reloads");
+        F->Push(metrics.runTime);
+        lua_setfield(F->L, -2, "runTime");
+
+        lua_createtable(F->L, metrics.hooks.size(), 0);
+        for (size_t i = 0; i < metrics.hooks.size(); ++i)
+        {
+            lua_createtable(F->L, 0, 4);
+            F->Push(metrics.hooks[i].regtype);
+            lua_setfield(F->L, -2, "regtype");
+            F->Push(metrics.hooks[i].event);
+            lua_setfield(F->L, -2, "event");
+            F->Push(double(metrics.hooks[i].calls));
+            lua_setfield(F->L, -2, "calls");
+            F->Push(double(metrics.hooks[i].time));
+            lua_setfield(F->L, -2, "time");
+            lua_rawseti(F->L, -2, i + 1);
+        }
+        lua_setfield(F->L, -2, "hooks");
+        return 1;
+    }
+
     /**
      * Performs an in-game spawn and returns the [Creature] or [GameObject] spawned.
      *
@@ -3119,6 +3361,10 @@ namespace LuaGlobalFunctions
         { "GetStateMap", &LuaGlobalFunctions::GetStateMap, METHOD_REG_MAP }, // Map state method only in multistate
         { "GetStateMapId", &LuaGlobalFunctions::GetStateMapId },
         { "GetStateInstanceId", &LuaGlobalFunctions::GetStateInstanceId },
+        { "GetTickBudgetUsage", &LuaGlobalFunctions::GetTickBudgetUsage },
+        { "GetWatchdogAborts", &LuaGlobalFunctions::GetWatchdogAborts },
+        { "GetForgeProfile", &LuaGlobalFunctions::GetForgeProfile },
+        { "GetForgeMetrics", &LuaGlobalFunctions::GetForgeMetrics },
         { "GetQuest", &LuaGlobalFunctions::GetQuest },
         { "GetPlayerByGUID", &LuaGlobalFunctions::GetPlayerByGUID, METHOD_REG_WORLD }, // World state method only in multistate
         { "GetPlayerByName", &LuaGlobalFunctions::GetPlayerByName, METHOD_REG_WORLD }, // World state method only in multistate
@@ -3175,6 +3421,8 @@ namespace LuaGlobalFunctions
         { "CreateLuaEvent", &LuaGlobalFunctions::CreateLuaEvent },
         { "RemoveEventById", &LuaGlobalFunctions::RemoveEventById },
         { "RemoveEvents", &LuaGlobalFunctions::RemoveEvents },
+        { "RunCoroutine", &LuaGlobalFunctions::RunCoroutine },
+        { "Defer", &LuaGlobalFunctions::Defer },
         { "PerformIngameSpawn", &LuaGlobalFunctions::PerformIngameSpawn },
         { "CreatePacket", &LuaGlobalFunctions::CreatePacket },
         { "AddVendorItem", &LuaGlobalFunctions::AddVendorItem },
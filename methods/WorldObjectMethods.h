@@ -727,6 +727,8 @@ namespace LuaWorldObject
      *
      * Note that for [Creature] and [GameObject] the timed event timer ticks only if the creature is in sight of someone
      * For all [WorldObject]s the timed events are removed when the object is destoryed. This means that for example a [Player]'s events are removed on logout.
+     * With `Forge.BatchedObjectTimers` enabled the timers of a map state tick with the map instead. They are removed when a [Creature] or [GameObject] is removed from the world
+     * or a [Player] leaves the map. The timers of other objects are removed when they are due and the object is no longer on the map.
      *
      *     local function Timed(eventid, delay, repeats, worldobject)
      *         print(worldobject:GetName())
@@ -771,7 +773,10 @@ namespace LuaWorldObject
         int functionRef = luaL_ref(F->L, LUA_REGISTRYINDEX);
         if (functionRef != LUA_REFNIL && functionRef != LUA_NOREF)
         {
-            obj->GetForgeEvents(F->GetBoundMapId())->AddEvent(functionRef, min, max, repeats);
+            if (ForgeEventProcessor* batched = F->eventMgr->objectProcessor)
+                batched->AddEvent(functionRef, min, max, repeats, obj->GET_GUID());
+            else
+                obj->GetForgeEvents(F->GetBoundMapId())->AddEvent(functionRef, min, max, repeats);
             F->Push(functionRef);
         }
         return 1;
@@ -786,7 +791,10 @@ namespace LuaWorldObject
     int RemoveEventById(Forge* F, WorldObject* obj)
     {
         int eventId = F->CHECKVAL<int>(2);
-        obj->GetForgeEvents(F->GetBoundMapId())->SetState(eventId, LUAEVENT_STATE_ABORT);
+        if (ForgeEventProcessor* batched = F->eventMgr->objectProcessor)
+            batched->SetState(obj->GET_GUID(), eventId, LUAEVENT_STATE_ABORT);
+        else
+            obj->GetForgeEvents(F->GetBoundMapId())->SetState(eventId, LUAEVENT_STATE_ABORT);
         return 0;
     }
 
@@ -797,7 +805,10 @@ namespace LuaWorldObject
      */
     int RemoveEvents(Forge* F, WorldObject* obj)
     {
-        obj->GetForgeEvents(F->GetBoundMapId())->SetStates(LUAEVENT_STATE_ABORT);
+        if (ForgeEventProcessor* batched = F->eventMgr->objectProcessor)
+            batched->SetStates(obj->GET_GUID(), LUAEVENT_STATE_ABORT);
+        else
+            obj->GetForgeEvents(F->GetBoundMapId())->SetStates(LUAEVENT_STATE_ABORT);
         return 0;
     }
 